@@ -0,0 +1,124 @@
+#include <slab_allocator.h>
+#include <unrolled_list.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Сравнение обхода списка по next с обходом с предвыборкой нод. Ноды берутся из slab_arena, свободный
+// список которой заранее перемешан: соседние ноды списка лежат в случайных местах памяти, как после
+// долгой жизни с вставками и удалениями, и аппаратный предвыборщик соседние линии не угадывает.
+// Запуск: unrolled-list-prefetch-bench [число элементов] [повторы]. Чтобы проход был холодным,
+// список должен быть больше кэша последнего уровня.
+// Для каждого обхода печатаются время первого прохода и лучшее из повторов. Перед первым проходом
+// prefetched_segments индекс позиций сброшен, как после вставки в середину или сортировки, поэтому
+// первый проход включает перестройку индекса, а лучший показывает обход с уже готовым индексом
+
+using list_type = unrolled_list<long long, node_capacity_for_budget<long long>, slab_allocator<long long>>;
+using node_type = list_type::Node;
+
+// Выдаёт из арены node_count блоков под ноды и возвращает их в случайном порядке
+void shuffle_arena(slab_arena& arena, size_t node_count) {
+    std::vector<void*> blocks(node_count);
+    for (void*& block : blocks) {
+        block = arena.allocate(sizeof(node_type), alignof(node_type));
+    }
+    std::shuffle(blocks.begin(), blocks.end(), std::mt19937_64(42));
+    for (void* block : blocks) {
+        arena.deallocate(block, sizeof(node_type));
+    }
+}
+
+// Время прохода в наносекундах на элемент: первого и лучшего из repeats
+struct Timing {
+    double first = 0;
+    double best = 0;
+};
+
+template<typename Scan>
+Timing measure(list_type& list, size_t repeats, Scan scan, long long expected) {
+    Timing timing;
+    for (size_t i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        long long result = scan(list);
+        auto finish = std::chrono::steady_clock::now();
+        if (result != expected) {
+            std::fprintf(stderr, "wrong sum %lld, expected %lld\n", result, expected);
+            std::exit(1);
+        }
+        double time = std::chrono::duration<double, std::nano>(finish - start).count() / list.size();
+        timing.first = i == 0 ? time : timing.first;
+        timing.best = i == 0 ? time : std::min(timing.best, time);
+    }
+    return timing;
+}
+
+void report(const char* name, Timing timing, double baseline) {
+    std::printf("%-26s %6.3f %6.3f ns/element", name, timing.first, timing.best);
+    if (baseline > 0) {
+        std::printf("   x%.2f x%.2f", baseline / timing.first, baseline / timing.best);
+    }
+    std::printf("\n");
+}
+
+template<typename Segments>
+long long sum_segments(Segments segments) {
+    long long result = 0;
+    for (auto segment : segments) {
+        result = std::accumulate(segment.begin(), segment.end(), result);
+    }
+    return result;
+}
+
+template<size_t PrefetchDistance>
+void report_prefetched(list_type& list, size_t repeats, long long expected, double baseline) {
+    list.index_invalidate();
+    Timing timing = measure(list, repeats, [](list_type& list) {
+        return sum_segments(list.prefetched_segments<PrefetchDistance>());
+    }, expected);
+    char name[32];
+    std::snprintf(name, sizeof(name), "prefetched_segments<%zu>", PrefetchDistance);
+    report(name, timing, baseline);
+}
+
+void run(size_t size, size_t repeats) {
+    slab_arena arena(1 << 20);
+    shuffle_arena(arena, size / node_capacity_for_budget<long long> + 1);
+    list_type list{slab_allocator<long long>(arena)};
+    for (size_t i = 0; i < size; ++i) {
+        list.push_back(static_cast<long long>(i));
+    }
+    long long expected = static_cast<long long>(size) * static_cast<long long>(size - 1) / 2;
+    std::printf("%zu elements, %zu nodes, %.1f MiB of nodes\n", list.size(), list.node_count,
+        static_cast<double>(list.node_count * sizeof(node_type)) / (1 << 20));
+
+    Timing iterator_time = measure(list, repeats, [](list_type& list) {
+        return std::accumulate(list.begin(), list.end(), 0LL);
+    }, expected);
+    Timing segments_time = measure(list, repeats, [](list_type& list) {
+        return sum_segments(list.segments());
+    }, expected);
+    double baseline = segments_time.best;
+    std::printf("%-26s  first   best   ns/element, speedup over the best segments() pass\n", "");
+    report("begin() .. end()", iterator_time, 0);
+    report("segments()", segments_time, baseline);
+    report_prefetched<2>(list, repeats, expected, baseline);
+    report_prefetched<4>(list, repeats, expected, baseline);
+    report_prefetched<default_prefetch_distance>(list, repeats, expected, baseline);
+    report_prefetched<16>(list, repeats, expected, baseline);
+    report_prefetched<32>(list, repeats, expected, baseline);
+}
+
+int main(int argc, char** argv) {
+    size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : size_t(1) << 26;
+    size_t repeats = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+    if (size == 0 || repeats == 0) {
+        std::fprintf(stderr, "usage: %s [elements] [repeats]\n", argv[0]);
+        return 1;
+    }
+    run(size, repeats);
+}
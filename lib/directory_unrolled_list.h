@@ -0,0 +1,710 @@
+#pragma once
+
+#include "unrolled_list.h"
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+template<typename T, size_t NodeMaxSize, typename Allocator>
+class directory_unrolled_list;
+
+// Вместимость ноды directory_unrolled_list под бюджет в байтах, как node_capacity_for_budget у unrolled_list.
+// Заголовок здесь короче, поэтому элементов в тот же бюджет входит больше
+template<typename T, size_t ByteBudget = 4 * cache_line_size>
+inline constexpr size_t directory_node_capacity_for_budget =
+    node_capacity_for_offset<T, directory_unrolled_list<T, 1, std::allocator<T>>::node_storage_offset, ByteBudget>;
+
+// Вариант unrolled_list с каталогом нод, как у std::deque: рядом со связями prev/next хранится
+// непрерывный массив указателей на ноды в порядке цепочки. Все ноды, кроме крайних, заполнены целиком,
+// элемент с номером i лежит в ноде (front_offset + i) / NodeMaxSize каталога, поэтому нода находится
+// за O(1), а итератор произвольного доступа. Платой за это служит вставка и удаление в середине
+// за O(min(i, N - i)) сдвигом элементов к ближайшему краю. Перевыделение каталога при добавлении
+// ноды с края делает итераторы недействительными, ссылки на элементы остаются действительными
+template<typename T, size_t NodeMaxSize = directory_node_capacity_for_budget<T>, typename Allocator = std::allocator<T>>
+class directory_unrolled_list {
+    static_assert(NodeMaxSize > 0, "NodeMaxSize must be positive");
+
+public:
+
+    // Слоты ноды заняты подряд: у первой ноды с front_offset до конца, у последней с начала
+    class alignas(cache_line_size) Node {
+    public:
+        Node* next = nullptr;
+        Node* prev = nullptr;
+        alignas(T) unsigned char storage[sizeof(T) * NodeMaxSize];
+
+        T* slot(size_t index) {
+            return std::launder(reinterpret_cast<T*>(storage)) + index;
+        }
+        const T* slot(size_t index) const {
+            return std::launder(reinterpret_cast<const T*>(storage)) + index;
+        }
+    };
+    static constexpr size_t node_storage_offset = offsetof(Node, storage);
+
+    size_t list_size = 0;
+    size_t front_offset = 0;
+    Node* head = nullptr;
+    Node* tail = nullptr;
+
+    // Занятые слоты каталога [directory_first, directory_first + node_count). Свободное место держится
+    // с обеих сторон, поэтому добавление ноды в любой конец в среднем не двигает каталог
+    Node** directory = nullptr;
+    size_t directory_capacity = 0;
+    size_t directory_first = 0;
+    size_t node_count = 0;
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    NodeAllocator node_allocator;
+    using DirectoryAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node*>;
+    DirectoryAllocator directory_allocator;
+    using ElementAllocator = std::allocator_traits<Allocator>;
+    Allocator element_allocator;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    // Итератор - слот каталога и номер слота в ноде. Сдвиг на n считается делением без обхода нод
+    template<bool IsConst>
+    class BasicIterator {
+    public:
+        Node* const* node_slot = nullptr;
+        size_t current_index = 0;
+
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        BasicIterator() = default;
+
+        BasicIterator(Node* const* node_slot, size_t index) : node_slot(node_slot), current_index(index) {}
+
+        template<bool OtherConst> requires (IsConst && !OtherConst)
+        BasicIterator(const BasicIterator<OtherConst>& other)
+            : node_slot(other.node_slot), current_index(other.current_index) {}
+
+        reference operator*() const {
+            return *(*node_slot)->slot(current_index);
+        }
+        pointer operator->() const {
+            return (*node_slot)->slot(current_index);
+        }
+        reference operator[](difference_type n) const {
+            return *(*this + n);
+        }
+        BasicIterator& operator++() {
+            if (++current_index == NodeMaxSize) {
+                ++node_slot;
+                current_index = 0;
+            }
+            return *this;
+        }
+        BasicIterator operator++(int) {
+            BasicIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        BasicIterator& operator--() {
+            if (current_index == 0) {
+                --node_slot;
+                current_index = NodeMaxSize - 1;
+            } else {
+                --current_index;
+            }
+            return *this;
+        }
+        BasicIterator operator--(int) {
+            BasicIterator temp = *this;
+            --(*this);
+            return temp;
+        }
+        BasicIterator& operator+=(difference_type n) {
+            constexpr difference_type node_max_size = NodeMaxSize;
+            difference_type offset = static_cast<difference_type>(current_index) + n;
+            difference_type node_shift = offset >= 0 ? offset / node_max_size : -((-offset - 1) / node_max_size) - 1;
+            node_slot += node_shift;
+            current_index = static_cast<size_t>(offset - node_shift * node_max_size);
+            return *this;
+        }
+        BasicIterator& operator-=(difference_type n) {
+            return *this += -n;
+        }
+        BasicIterator operator+(difference_type n) const {
+            BasicIterator temp = *this;
+            return temp += n;
+        }
+        friend BasicIterator operator+(difference_type n, const BasicIterator& it) {
+            return it + n;
+        }
+        BasicIterator operator-(difference_type n) const {
+            BasicIterator temp = *this;
+            return temp -= n;
+        }
+        difference_type operator-(const BasicIterator& other) const {
+            return (node_slot - other.node_slot) * static_cast<difference_type>(NodeMaxSize)
+                + static_cast<difference_type>(current_index) - static_cast<difference_type>(other.current_index);
+        }
+        bool operator==(const BasicIterator& other) const {
+            return node_slot == other.node_slot && current_index == other.current_index;
+        }
+        std::strong_ordering operator<=>(const BasicIterator& other) const {
+            if (node_slot != other.node_slot) {
+                return node_slot <=> other.node_slot;
+            }
+            return current_index <=> other.current_index;
+        }
+    };
+
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    directory_unrolled_list() = default;
+    explicit directory_unrolled_list(const Allocator& alloc)
+        : node_allocator(alloc), directory_allocator(alloc), element_allocator(alloc) {}
+    directory_unrolled_list(size_t count, const T& value, const Allocator& alloc = Allocator())
+        : directory_unrolled_list(alloc) {
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                emplace_back(value);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+    template<typename InputIterator> requires (!std::is_integral_v<InputIterator>)
+    directory_unrolled_list(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+        : directory_unrolled_list(alloc) {
+        try {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+    directory_unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : directory_unrolled_list(init.begin(), init.end(), alloc) {}
+    directory_unrolled_list(const directory_unrolled_list& other)
+        : directory_unrolled_list(other,
+            ElementAllocator::select_on_container_copy_construction(other.element_allocator)) {}
+    directory_unrolled_list(const directory_unrolled_list& other, const Allocator& alloc)
+        : directory_unrolled_list(other.begin(), other.end(), alloc) {}
+    directory_unrolled_list(directory_unrolled_list&& other) noexcept
+        : node_allocator(std::move(other.node_allocator)), directory_allocator(std::move(other.directory_allocator)),
+          element_allocator(std::move(other.element_allocator)) {
+        swap_state(other);
+    }
+    directory_unrolled_list(directory_unrolled_list&& other, const Allocator& alloc)
+        : directory_unrolled_list(alloc) {
+        if (allocators_equal(other)) {
+            swap_state(other);
+            return;
+        }
+        try {
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+        other.clear();
+    }
+
+    ~directory_unrolled_list() noexcept {
+        release();
+    }
+
+    static constexpr bool propagate_on_move_assignment =
+        std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value;
+    static constexpr bool allocators_always_equal = std::allocator_traits<NodeAllocator>::is_always_equal::value;
+
+    bool allocators_equal(const directory_unrolled_list& other) const noexcept {
+        if constexpr (allocators_always_equal) {
+            return true;
+        } else {
+            return node_allocator == other.node_allocator;
+        }
+    }
+
+    directory_unrolled_list& operator=(const directory_unrolled_list& other) {
+        if (this == &other) {
+            return *this;
+        }
+        directory_unrolled_list copy(other,
+            std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value
+            ? other.element_allocator : element_allocator);
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value) {
+            release();
+            node_allocator = other.node_allocator;
+            directory_allocator = other.directory_allocator;
+            element_allocator = other.element_allocator;
+        }
+        swap_state(copy);
+        return *this;
+    }
+    directory_unrolled_list& operator=(directory_unrolled_list&& other)
+        noexcept(propagate_on_move_assignment || allocators_always_equal) {
+        if (this == &other) {
+            return *this;
+        }
+        release();
+        if constexpr (propagate_on_move_assignment) {
+            node_allocator = std::move(other.node_allocator);
+            directory_allocator = std::move(other.directory_allocator);
+            element_allocator = std::move(other.element_allocator);
+        } else if (!allocators_equal(other)) {
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+            other.clear();
+            return *this;
+        }
+        swap_state(other);
+        return *this;
+    }
+    directory_unrolled_list& operator=(std::initializer_list<T> init) {
+        directory_unrolled_list copy(init, element_allocator);
+        swap_state(copy);
+        return *this;
+    }
+    void swap_state(directory_unrolled_list& other) noexcept {
+        std::swap(list_size, other.list_size);
+        std::swap(front_offset, other.front_offset);
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(directory, other.directory);
+        std::swap(directory_capacity, other.directory_capacity);
+        std::swap(directory_first, other.directory_first);
+        std::swap(node_count, other.node_count);
+    }
+    void swap(directory_unrolled_list& other) noexcept {
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value) {
+            std::swap(node_allocator, other.node_allocator);
+            std::swap(directory_allocator, other.directory_allocator);
+            std::swap(element_allocator, other.element_allocator);
+        }
+        swap_state(other);
+    }
+    friend void swap(directory_unrolled_list& lhs, directory_unrolled_list& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    bool operator==(const directory_unrolled_list& other) const {
+        return list_size == other.list_size && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const directory_unrolled_list& other) const {
+        return !(*this == other);
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return element_allocator;
+    }
+    bool empty() const {
+        return list_size == 0;
+    }
+    size_t size() const {
+        return list_size;
+    }
+    size_t max_size() const {
+        return std::numeric_limits<difference_type>::max() / sizeof(T);
+    }
+
+    iterator begin() {
+        return position_iterator<false>(0);
+    }
+    iterator end() {
+        return position_iterator<false>(list_size);
+    }
+    const_iterator begin() const {
+        return position_iterator<true>(0);
+    }
+    const_iterator end() const {
+        return position_iterator<true>(list_size);
+    }
+    const_iterator cbegin() const {
+        return begin();
+    }
+    const_iterator cend() const {
+        return end();
+    }
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const {
+        return rbegin();
+    }
+    const_reverse_iterator crend() const {
+        return rend();
+    }
+
+    reference front() {
+        return *head->slot(front_offset);
+    }
+    const_reference front() const {
+        return *head->slot(front_offset);
+    }
+    reference back() {
+        return (*this)[list_size - 1];
+    }
+    const_reference back() const {
+        return (*this)[list_size - 1];
+    }
+
+    reference operator[](size_t position) {
+        size_t offset = front_offset + position;
+        return *directory[directory_first + offset / NodeMaxSize]->slot(offset % NodeMaxSize);
+    }
+    const_reference operator[](size_t position) const {
+        size_t offset = front_offset + position;
+        return *directory[directory_first + offset / NodeMaxSize]->slot(offset % NodeMaxSize);
+    }
+    reference at(size_t position) {
+        if (position >= list_size) {
+            throw std::out_of_range("directory_unrolled_list::at");
+        }
+        return (*this)[position];
+    }
+    const_reference at(size_t position) const {
+        if (position >= list_size) {
+            throw std::out_of_range("directory_unrolled_list::at");
+        }
+        return (*this)[position];
+    }
+    iterator nth(size_t position) {
+        return position_iterator<false>(std::min(position, list_size));
+    }
+    const_iterator nth(size_t position) const {
+        return position_iterator<true>(std::min(position, list_size));
+    }
+    size_t index_of(const_iterator pos) const {
+        return static_cast<size_t>(pos - begin());
+    }
+    template<bool IsConst>
+    BasicIterator<IsConst> position_iterator(size_t position) const {
+        size_t offset = front_offset + position;
+        return {directory + directory_first + offset / NodeMaxSize, offset % NodeMaxSize};
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        size_t offset = front_offset + list_size;
+        if (offset == node_count * NodeMaxSize) {
+            reserve_directory(0, 1);
+            Node* node = allocate_node();
+            try {
+                ElementAllocator::construct(element_allocator, node->slot(0), std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate_node(node);
+                throw;
+            }
+            link_back(node);
+            ++list_size;
+            return *node->slot(0);
+        }
+        T* place = tail->slot(offset % NodeMaxSize);
+        ElementAllocator::construct(element_allocator, place, std::forward<Args>(args)...);
+        ++list_size;
+        return *place;
+    }
+    template<typename... Args>
+    reference emplace_front(Args&&... args) {
+        if (front_offset == 0) {
+            reserve_directory(1, 0);
+            Node* node = allocate_node();
+            try {
+                ElementAllocator::construct(element_allocator, node->slot(NodeMaxSize - 1),
+                    std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate_node(node);
+                throw;
+            }
+            link_front(node);
+            front_offset = NodeMaxSize - 1;
+            ++list_size;
+            return *node->slot(front_offset);
+        }
+        T* place = head->slot(front_offset - 1);
+        ElementAllocator::construct(element_allocator, place, std::forward<Args>(args)...);
+        --front_offset;
+        ++list_size;
+        return *place;
+    }
+    // Новый элемент занимает место у ближайшего края, а элементы между краем и позицией
+    // сдвигаются на одну перемещающим присваиванием
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        size_t position = index_of(pos);
+        if (position == list_size) {
+            emplace_back(std::forward<Args>(args)...);
+            return nth(position);
+        }
+        if (position == 0) {
+            emplace_front(std::forward<Args>(args)...);
+            return begin();
+        }
+        T value(std::forward<Args>(args)...);
+        if (position < list_size / 2) {
+            emplace_front(std::move(front()));
+            std::move(begin() + 2, begin() + (position + 1), begin() + 1);
+        } else {
+            emplace_back(std::move(back()));
+            std::move_backward(begin() + position, end() - 2, end() - 1);
+        }
+        iterator result = nth(position);
+        *result = std::move(value);
+        return result;
+    }
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+    void push_front(const T& value) {
+        emplace_front(value);
+    }
+    void push_front(T&& value) {
+        emplace_front(std::move(value));
+    }
+    iterator insert(const_iterator pos, const T& value) {
+        return emplace(pos, value);
+    }
+    iterator insert(const_iterator pos, T&& value) {
+        return emplace(pos, std::move(value));
+    }
+    iterator insert(const_iterator pos, size_t count, const T& value) {
+        // value может лежать в самом списке и сдвинуться после первой вставки
+        T copy(value);
+        size_t inserted = 0;
+        return insert_near_edge(pos, [&] { return inserted < count; }, [&](bool front) {
+            front ? emplace_front(copy) : emplace_back(copy);
+            ++inserted;
+        });
+    }
+    template<typename InputIterator> requires (!std::is_integral_v<InputIterator>)
+    iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+        return insert_near_edge(pos, [&] { return first != last; }, [&](bool front) {
+            front ? emplace_front(*first) : emplace_back(*first);
+            ++first;
+        });
+    }
+    // Как и emplace, новые элементы строятся у ближайшего к pos края и встают на место поворотом
+    // элементов между краем и позицией: середина нод не разрезается, поэтому сдвигается только более
+    // короткая сторона. Если конструктор выбросит исключение, уже построенные элементы снимаются с края
+    // и список не меняется
+    template<typename HasNext, typename EmplaceNext>
+    iterator insert_near_edge(const_iterator pos, HasNext has_next, EmplaceNext emplace_next) {
+        size_t position = index_of(pos);
+        size_t old_size = list_size;
+        bool front = position < list_size - position;
+        try {
+            while (has_next()) {
+                emplace_next(front);
+            }
+        } catch (...) {
+            while (list_size > old_size) {
+                front ? pop_front() : pop_back();
+            }
+            throw;
+        }
+        size_t count = list_size - old_size;
+        if (front) {
+            // С переднего края элементы легли в обратном порядке
+            std::reverse(begin(), begin() + count);
+            std::rotate(begin(), begin() + count, begin() + (count + position));
+        } else {
+            std::rotate(begin() + position, begin() + old_size, end());
+        }
+        return nth(position);
+    }
+    iterator insert(const_iterator pos, std::initializer_list<T> init) {
+        return insert(pos, init.begin(), init.end());
+    }
+    void pop_back() noexcept {
+        size_t offset = front_offset + list_size - 1;
+        ElementAllocator::destroy(element_allocator, tail->slot(offset % NodeMaxSize));
+        --list_size;
+        if (list_size == 0 || offset % NodeMaxSize == 0) {
+            unlink_back();
+        }
+    }
+    void pop_front() noexcept {
+        ElementAllocator::destroy(element_allocator, head->slot(front_offset));
+        --list_size;
+        if (list_size == 0 || ++front_offset == NodeMaxSize) {
+            unlink_front();
+        }
+    }
+    iterator erase(const_iterator pos) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        return erase(pos, pos + 1);
+    }
+    // Закрывает дыру сдвигом более короткой стороны, освободившиеся элементы снимаются с края
+    iterator erase(const_iterator first, const_iterator last) noexcept(std::is_nothrow_move_assignable_v<T>) {
+        size_t position = index_of(first);
+        size_t count = static_cast<size_t>(last - first);
+        if (count == 0) {
+            return nth(position);
+        }
+        if (position < list_size - position - count) {
+            std::move_backward(begin(), begin() + position, begin() + (position + count));
+            for (size_t i = 0; i < count; ++i) {
+                pop_front();
+            }
+        } else {
+            std::move(begin() + (position + count), end(), begin() + position);
+            for (size_t i = 0; i < count; ++i) {
+                pop_back();
+            }
+        }
+        return nth(position);
+    }
+
+    // Каталог остаётся выделенным, как ёмкость у std::vector
+    void clear() noexcept {
+        for (T& item : *this) {
+            ElementAllocator::destroy(element_allocator, std::addressof(item));
+        }
+        Node* node = head;
+        while (node) {
+            Node* next_node = node->next;
+            deallocate_node(node);
+            node = next_node;
+        }
+        list_size = 0;
+        front_offset = 0;
+        head = nullptr;
+        tail = nullptr;
+        node_count = 0;
+        directory_first = directory_capacity / 2;
+    }
+    void release() noexcept {
+        clear();
+        if (directory_capacity > 0) {
+            std::allocator_traits<DirectoryAllocator>::deallocate(directory_allocator, directory, directory_capacity);
+        }
+        directory = nullptr;
+        directory_capacity = 0;
+        directory_first = 0;
+    }
+
+    // Гарантирует место под front нод перед первой и back нод после последней. Если каталог заполнен
+    // не больше чем наполовину, занятая часть переносится в середину, иначе каталог растёт вдвое
+    void reserve_directory(size_t front, size_t back) {
+        if (directory_first >= front && directory_capacity - directory_first - node_count >= back) {
+            return;
+        }
+        size_t needed = node_count + front + back;
+        if (needed * 2 <= directory_capacity) {
+            size_t first = (directory_capacity - needed) / 2 + front;
+            std::memmove(directory + first, directory + directory_first, node_count * sizeof(Node*));
+            directory_first = first;
+            return;
+        }
+        size_t capacity = std::max<size_t>(needed * 2, 8);
+        Node** nodes = std::allocator_traits<DirectoryAllocator>::allocate(directory_allocator, capacity);
+        size_t first = (capacity - needed) / 2 + front;
+        if (node_count > 0) {
+            std::memcpy(nodes + first, directory + directory_first, node_count * sizeof(Node*));
+        }
+        if (directory_capacity > 0) {
+            std::allocator_traits<DirectoryAllocator>::deallocate(directory_allocator, directory, directory_capacity);
+        }
+        directory = nodes;
+        directory_capacity = capacity;
+        directory_first = first;
+    }
+    void link_back(Node* node) noexcept {
+        directory[directory_first + node_count] = node;
+        ++node_count;
+        node->prev = tail;
+        if (tail) {
+            tail->next = node;
+        } else {
+            head = node;
+        }
+        tail = node;
+    }
+    void link_front(Node* node) noexcept {
+        directory[--directory_first] = node;
+        ++node_count;
+        node->next = head;
+        if (head) {
+            head->prev = node;
+        } else {
+            tail = node;
+        }
+        head = node;
+    }
+    // Пустой список возвращается в середину каталога, чтобы рост в любую сторону не двигал его
+    void unlink_back() noexcept {
+        Node* node = tail;
+        tail = node->prev;
+        if (tail) {
+            tail->next = nullptr;
+        } else {
+            head = nullptr;
+        }
+        deallocate_node(node);
+        if (--node_count == 0) {
+            front_offset = 0;
+            directory_first = directory_capacity / 2;
+        }
+    }
+    void unlink_front() noexcept {
+        Node* node = head;
+        head = node->next;
+        if (head) {
+            head->prev = nullptr;
+        } else {
+            tail = nullptr;
+        }
+        deallocate_node(node);
+        ++directory_first;
+        front_offset = 0;
+        if (--node_count == 0) {
+            directory_first = directory_capacity / 2;
+        }
+    }
+
+    Node* allocate_node() {
+        Node* node = std::allocator_traits<NodeAllocator>::allocate(node_allocator, 1);
+        node->next = nullptr;
+        node->prev = nullptr;
+        return node;
+    }
+    void deallocate_node(Node* node) noexcept {
+        std::allocator_traits<NodeAllocator>::deallocate(node_allocator, node, 1);
+    }
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "unrolled_list.h"
+
+#include <memory>
+#include <optional>
+
+// Параллельные проходы по unrolled_list. Цепочка нод режется на прогоны целых нод с примерно равным
+// числом элементов: при построенном индексе позиций границы находятся по нему за O(log) каждая, иначе
+// за один проход по цепочке нод. Индекс при этом не строится, так что константный список можно
+// обходить из нескольких потоков сразу. Каждый прогон обрабатывается одной задачей пула по непрерывным
+// кускам нод. Функторы вызываются из разных потоков одновременно; список во время прохода менять нельзя
+
+// Меньше элементов на прогон не даём: накладные расходы на задачу съели бы выигрыш
+inline constexpr size_t parallel_min_run_size = 16 * 1024;
+// Прогонов больше, чем потоков, чтобы неравномерные по стоимости элементы не держали всех на одном потоке
+inline constexpr size_t parallel_runs_per_thread = 4;
+
+// Массив из count построенных по умолчанию элементов в памяти, выделенной аллокатором списка
+template<typename T, typename Allocator>
+class parallel_buffer {
+public:
+    using BufferAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+    BufferAllocator allocator;
+    T* data = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    parallel_buffer(const Allocator& alloc, size_t size) : allocator(alloc) {
+        data = std::allocator_traits<BufferAllocator>::allocate(allocator, size);
+        capacity = size;
+        try {
+            for (; count < size; ++count) {
+                std::allocator_traits<BufferAllocator>::construct(allocator, data + count);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+    parallel_buffer(parallel_buffer&& other) noexcept
+        : allocator(other.allocator), data(std::exchange(other.data, nullptr)),
+        count(std::exchange(other.count, 0)), capacity(std::exchange(other.capacity, 0)) {}
+    parallel_buffer& operator=(parallel_buffer&&) = delete;
+    ~parallel_buffer() noexcept {
+        release();
+    }
+
+    void release() noexcept {
+        if (!data) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            std::allocator_traits<BufferAllocator>::destroy(allocator, data + i);
+        }
+        std::allocator_traits<BufferAllocator>::deallocate(allocator, data, capacity);
+    }
+    T& operator[](size_t index) noexcept {
+        return data[index];
+    }
+    T* begin() noexcept {
+        return data;
+    }
+    T* end() noexcept {
+        return data + count;
+    }
+};
+
+// Прогоны [runs[i], runs[i + 1]) из целых нод, последний заканчивается nullptr. В конце массива
+// могут остаться неиспользованные слоты, поэтому число прогонов возвращается через run_count
+template<typename List>
+auto split_into_runs(List& list, const thread_pool& pool, size_t& run_count) {
+    using NodePointer = decltype(list.begin().current_node);
+    size_t size = list.size();
+    size_t max_runs = std::min(pool.concurrency() * parallel_runs_per_thread,
+        (size + parallel_min_run_size - 1) / parallel_min_run_size);
+    max_runs = std::max<size_t>(max_runs, 1);
+    parallel_buffer<NodePointer, typename List::allocator_type> runs(list.get_allocator(), max_runs + 1);
+    run_count = 0;
+    if (size == 0) {
+        runs[0] = nullptr;
+        return runs;
+    }
+    runs[0] = list.head;
+    run_count = 1;
+    auto add_bound = [&](NodePointer node) {
+        if (node != runs[run_count - 1]) {
+            runs[run_count++] = node;
+        }
+    };
+    if (list.index_valid) {
+        for (size_t i = 1; i < max_runs; ++i) {
+            add_bound(list.nth(size / max_runs * i).current_node);
+        }
+    } else {
+        // Граница i - нода с элементом size / max_runs * i, как и при поиске по индексу
+        size_t passed = 0;
+        size_t i = 1;
+        for (NodePointer node = list.head; node && i < max_runs; passed += node->node_size, node = node->next) {
+            for (; i < max_runs && size / max_runs * i < passed + node->node_size; ++i) {
+                add_bound(node);
+            }
+        }
+    }
+    runs[run_count] = nullptr;
+    return runs;
+}
+
+// Вызывает function для каждого непрерывного куска элементов нод прогона [first, last)
+template<typename NodePointer, typename Function>
+void for_each_run_segment(NodePointer first, NodePointer last, Function&& function) {
+    for (NodePointer node = first; node != last; node = node->next) {
+        size_t first_size = node->first_part_size();
+        function(node->slot(node->start), first_size);
+        if (first_size < node->node_size) {
+            function(node->slot(0), node->node_size - first_size);
+        }
+    }
+}
+
+// Общая часть константной и неконстантной версий parallel_for_each
+template<typename List, typename Function>
+void for_each_in_runs(thread_pool& pool, List& list, Function& function) {
+    size_t run_count;
+    auto runs = split_into_runs(list, pool, run_count);
+    pool.run(run_count, [&](size_t run) {
+        for_each_run_segment(runs[run], runs[run + 1], [&](auto* data, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                function(data[i]);
+            }
+        });
+    });
+}
+
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+void parallel_for_each(thread_pool& pool, unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        Function function) {
+    for_each_in_runs(pool, list, function);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+void parallel_for_each(thread_pool& pool,
+        const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Function function) {
+    for_each_in_runs(pool, list, function);
+}
+// Заменяет каждый элемент на operation(элемент)
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Operation>
+void parallel_transform(thread_pool& pool, unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        Operation operation) {
+    size_t run_count;
+    auto runs = split_into_runs(list, pool, run_count);
+    pool.run(run_count, [&](size_t run) {
+        for_each_run_segment(runs[run], runs[run + 1], [&](T* data, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                data[i] = operation(std::as_const(data[i]));
+            }
+        });
+    });
+}
+// Как std::reduce: operation должна быть ассоциативной и коммутативной. Частичные результаты прогонов
+// сворачиваются с init в порядке прогонов
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Value,
+    typename BinaryOperation = std::plus<>>
+Value parallel_reduce(thread_pool& pool,
+        const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Value init,
+        BinaryOperation operation = BinaryOperation()) {
+    size_t run_count;
+    auto runs = split_into_runs(list, pool, run_count);
+    parallel_buffer<std::optional<Value>, Allocator> partial(list.get_allocator(), run_count);
+    pool.run(run_count, [&](size_t run) {
+        std::optional<Value>& result = partial[run];
+        for_each_run_segment(runs[run], runs[run + 1], [&](const T* data, size_t count) {
+            size_t i = 0;
+            if (!result) {
+                result.emplace(data[i++]);
+            }
+            Value& value = *result;
+            for (; i < count; ++i) {
+                value = operation(std::move(value), data[i]);
+            }
+        });
+    });
+    for (std::optional<Value>& result : partial) {
+        if (result) {
+            init = operation(std::move(init), std::move(*result));
+        }
+    }
+    return init;
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Predicate>
+size_t parallel_count_if(thread_pool& pool,
+        const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Predicate pred) {
+    size_t run_count;
+    auto runs = split_into_runs(list, pool, run_count);
+    parallel_buffer<size_t, Allocator> partial(list.get_allocator(), run_count);
+    pool.run(run_count, [&](size_t run) {
+        size_t result = 0;
+        for_each_run_segment(runs[run], runs[run + 1], [&](const T* data, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                result += static_cast<bool>(pred(data[i]));
+            }
+        });
+        partial[run] = result;
+    });
+    size_t result = 0;
+    for (size_t count : partial) {
+        result += count;
+    }
+    return result;
+}
+
+// Те же алгоритмы на default_thread_pool()
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+void parallel_for_each(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Function function) {
+    parallel_for_each(default_thread_pool(), list, std::move(function));
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+void parallel_for_each(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        Function function) {
+    parallel_for_each(default_thread_pool(), list, std::move(function));
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Operation>
+void parallel_transform(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        Operation operation) {
+    parallel_transform(default_thread_pool(), list, std::move(operation));
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Value,
+    typename BinaryOperation = std::plus<>>
+Value parallel_reduce(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Value init,
+        BinaryOperation operation = BinaryOperation()) {
+    return parallel_reduce(default_thread_pool(), list, std::move(init), std::move(operation));
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Predicate>
+size_t parallel_count_if(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        Predicate pred) {
+    return parallel_count_if(default_thread_pool(), list, std::move(pred));
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+// Арена, нарезающая блоки из больших выровненных по кэш-линии слэбов. Все блоки выровнены по кэш-линии
+// и округлены до кратного ей размера, поэтому нода никогда не делит линию с соседней.
+// Освобождённые блоки до max_reused_size байт складываются в списки по размерам и переиспользуются,
+// а вся память арены возвращается разом в release() или в деструкторе, без обхода отдельных блоков
+class slab_arena {
+public:
+    static constexpr size_t cache_line_size = 64;
+    static constexpr size_t default_slab_size = 64 * 1024;
+    static constexpr size_t size_class_count = 64;
+    static constexpr size_t max_reused_size = size_class_count * cache_line_size;
+
+    // Заголовок занимает первую кэш-линию слэба, блоки идут сразу за ним
+    struct Slab {
+        Slab* next;
+        size_t size;
+    };
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    size_t slab_size;
+    Slab* slabs = nullptr;
+    unsigned char* cursor = nullptr;
+    unsigned char* limit = nullptr;
+    FreeBlock* free_lists[size_class_count] = {};
+    size_t slab_count = 0;
+
+    explicit slab_arena(size_t slab_size = default_slab_size)
+        : slab_size(slab_size < 2 * cache_line_size ? 2 * cache_line_size : round_up(slab_size)) {}
+    slab_arena(const slab_arena&) = delete;
+    slab_arena& operator=(const slab_arena&) = delete;
+    ~slab_arena() noexcept {
+        release();
+    }
+
+    static constexpr size_t round_up(size_t bytes) noexcept {
+        return (bytes + cache_line_size - 1) / cache_line_size * cache_line_size;
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        if (alignment > cache_line_size || bytes > std::numeric_limits<size_t>::max() - 2 * cache_line_size) {
+            throw std::bad_alloc();
+        }
+        size_t size = round_up(bytes > 0 ? bytes : 1);
+        if (size <= max_reused_size) {
+            FreeBlock*& free_list = free_lists[size / cache_line_size - 1];
+            if (free_list) {
+                void* block = free_list;
+                free_list = free_list->next;
+                return block;
+            }
+        }
+        if (size > slab_size - cache_line_size) {
+            // Блок больше слэба получает отдельный слэб, не сбивая курсор текущего
+            Slab* slab = allocate_slab(size + cache_line_size);
+            if (slabs) {
+                slab->next = slabs->next;
+                slabs->next = slab;
+            } else {
+                slab->next = nullptr;
+                slabs = slab;
+            }
+            return payload(slab);
+        }
+        if (static_cast<size_t>(limit - cursor) < size) {
+            Slab* slab = allocate_slab(slab_size);
+            slab->next = slabs;
+            slabs = slab;
+            cursor = payload(slab);
+            limit = reinterpret_cast<unsigned char*>(slab) + slab_size;
+        }
+        void* block = cursor;
+        cursor += size;
+        return block;
+    }
+    // Крупные блоки не переиспользуются и остаются в арене до release()
+    void deallocate(void* block, size_t bytes) noexcept {
+        size_t size = round_up(bytes > 0 ? bytes : 1);
+        if (size <= max_reused_size) {
+            FreeBlock* free_block = ::new(block) FreeBlock{free_lists[size / cache_line_size - 1]};
+            free_lists[size / cache_line_size - 1] = free_block;
+        }
+    }
+    // Возвращает всю память арены. Контейнеры, использующие арену, к этому моменту должны быть
+    // уничтожены или больше не использоваться
+    void release() noexcept {
+        while (slabs) {
+            Slab* next_slab = slabs->next;
+            ::operator delete(static_cast<void*>(slabs), std::align_val_t(cache_line_size));
+            slabs = next_slab;
+        }
+        cursor = nullptr;
+        limit = nullptr;
+        for (FreeBlock*& free_list : free_lists) {
+            free_list = nullptr;
+        }
+        slab_count = 0;
+    }
+
+    Slab* allocate_slab(size_t size) {
+        Slab* slab = static_cast<Slab*>(::operator new(size, std::align_val_t(cache_line_size)));
+        slab->size = size;
+        ++slab_count;
+        return slab;
+    }
+    static unsigned char* payload(Slab* slab) noexcept {
+        return reinterpret_cast<unsigned char*>(slab) + cache_line_size;
+    }
+};
+
+// Аллокатор поверх slab_arena. Подключается через параметр Allocator, а rebind_alloc<Node>
+// даёт нодам блоки из той же арены. Копии аллокатора равны, если ссылаются на одну арену
+template<typename T>
+class slab_allocator {
+public:
+    static_assert(alignof(T) <= slab_arena::cache_line_size, "slab_allocator supports alignment up to a cache line");
+
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    slab_arena* arena;
+
+    explicit slab_allocator(slab_arena& arena) noexcept : arena(&arena) {}
+
+    template<typename U>
+    slab_allocator(const slab_allocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t count) noexcept {
+        arena->deallocate(pointer, count * sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const slab_allocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+    template<typename U>
+    bool operator!=(const slab_allocator<U>& other) const noexcept {
+        return arena != other.arena;
+    }
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Пул потоков для параллельных проходов по спискам. Работа подаётся пачкой из task_count независимых
+// задач: воркеры и вызывающий поток разбирают номера задач через общий счётчик, run() возвращается,
+// когда выполнены все. Ожидание построено на std::atomic::wait. За раз выполняется одна пачка,
+// задачи не должны вызывать run() того же пула
+class thread_pool {
+public:
+    using ThreadAllocator = std::allocator<std::thread>;
+    ThreadAllocator thread_allocator;
+    std::thread* workers = nullptr;
+    size_t worker_capacity = 0;
+    size_t worker_count = 0;
+    std::mutex run_mutex;
+
+    // Текущая пачка. Воркеры спят на generation и просыпаются, когда она увеличивается;
+    // busy_workers считает воркеров, ещё не закончивших текущую пачку
+    const std::function<void(size_t)>* task = nullptr;
+    size_t task_count = 0;
+    std::atomic<size_t> next_task = 0;
+    std::atomic<size_t> generation = 0;
+    std::atomic<size_t> busy_workers = 0;
+    std::atomic<bool> stopping = false;
+    std::mutex failure_mutex;
+    std::exception_ptr failure;
+    std::atomic<bool> failed = false;
+
+    // thread_count - общее число потоков вместе с вызывающим, поэтому воркеров на один меньше
+    explicit thread_pool(size_t thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1)) {
+        if (thread_count <= 1) {
+            return;
+        }
+        workers = std::allocator_traits<ThreadAllocator>::allocate(thread_allocator, thread_count - 1);
+        worker_capacity = thread_count - 1;
+        try {
+            for (; worker_count < worker_capacity; ++worker_count) {
+                std::allocator_traits<ThreadAllocator>::construct(thread_allocator, workers + worker_count,
+                    [this] { worker_loop(); });
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool() noexcept {
+        stop();
+    }
+
+    size_t concurrency() const noexcept {
+        return worker_count + 1;
+    }
+
+    // Выполняет function(0), ..., function(count - 1). Первое выброшенное задачей исключение
+    // пробрасывается после завершения уже начатых задач, ещё не начатые пропускаются
+    template<typename Function>
+    void run(size_t count, Function&& function) {
+        if (count == 0) {
+            return;
+        }
+        std::function<void(size_t)> wrapped = std::ref(function);
+        if (worker_count == 0 || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                wrapped(i);
+            }
+            return;
+        }
+        std::lock_guard run_lock(run_mutex);
+        task = &wrapped;
+        task_count = count;
+        next_task.store(0, std::memory_order_relaxed);
+        failure = nullptr;
+        failed.store(false, std::memory_order_relaxed);
+        busy_workers.store(worker_count, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+        execute_tasks();
+        for (size_t busy = busy_workers.load(std::memory_order_acquire); busy != 0;
+                busy = busy_workers.load(std::memory_order_acquire)) {
+            busy_workers.wait(busy, std::memory_order_acquire);
+        }
+        task = nullptr;
+        if (failure) {
+            std::rethrow_exception(std::exchange(failure, nullptr));
+        }
+    }
+
+    void execute_tasks() noexcept {
+        for (size_t i = next_task.fetch_add(1); i < task_count; i = next_task.fetch_add(1)) {
+            if (failed.load(std::memory_order_relaxed)) {
+                continue;
+            }
+            try {
+                (*task)(i);
+            } catch (...) {
+                std::lock_guard lock(failure_mutex);
+                if (!failure) {
+                    failure = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+    // Пачка не завершится, пока каждый воркер не отметится в busy_workers, поэтому следующая
+    // пачка не может начаться раньше, чем воркер увидел текущую
+    void worker_loop() noexcept {
+        size_t seen_generation = 0;
+        while (true) {
+            generation.wait(seen_generation, std::memory_order_acquire);
+            seen_generation = generation.load(std::memory_order_acquire);
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+            execute_tasks();
+            if (busy_workers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                busy_workers.notify_all();
+            }
+        }
+    }
+    void stop() noexcept {
+        stopping.store(true, std::memory_order_release);
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers[i].join();
+            std::allocator_traits<ThreadAllocator>::destroy(thread_allocator, workers + i);
+        }
+        if (workers) {
+            std::allocator_traits<ThreadAllocator>::deallocate(thread_allocator, workers, worker_capacity);
+        }
+        workers = nullptr;
+        worker_capacity = 0;
+        worker_count = 0;
+    }
+};
+
+// Общий пул на все потоки процессора, создаётся при первом обращении
+inline thread_pool& default_thread_pool() {
+    static thread_pool pool;
+    return pool;
+}
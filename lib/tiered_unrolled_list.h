@@ -0,0 +1,1146 @@
+#pragma once
+
+#include "unrolled_list.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Многоуровневый вариант unrolled_list: ноды с элементами являются листьями B+-дерева,
+// внутренние вершины которого хранят размеры поддеревьев. Позиционные вставка, удаление
+// и доступ работают за O(Fanout * log(N / NodeMaxSize) + NodeMaxSize), а обход по листьям
+// устроен так же, как у unrolled_list.
+// Вместимость листа по умолчанию не подбирается под бюджет в байтах, как у unrolled_list: лист
+// наследует от TreeNode общий с внутренними вершинами указатель на родителя, такой класс не является
+// standard-layout, и смещение элементов в нём нельзя измерить offsetof. Заголовок листа всё равно
+// лежит перед элементами, чтобы обход читал его из одной линии с первыми элементами
+template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>, size_t Fanout = 16>
+class tiered_unrolled_list {
+    static_assert(NodeMaxSize > 0, "NodeMaxSize must be positive");
+    static_assert(Fanout >= 4, "Fanout must be at least 4");
+
+public:
+
+    class Branch;
+
+    class TreeNode {
+    public:
+        Branch* parent = nullptr;
+    };
+
+    class Node : public TreeNode {
+    public:
+        size_t node_size = 0;
+        Node* next = nullptr;
+        Node* prev = nullptr;
+        alignas(T) unsigned char storage[sizeof(T) * NodeMaxSize];
+
+        T* element(size_t index) {
+            return std::launder(reinterpret_cast<T*>(storage)) + index;
+        }
+        const T* element(size_t index) const {
+            return std::launder(reinterpret_cast<const T*>(storage)) + index;
+        }
+        T& operator[](size_t index) {
+            return *element(index);
+        }
+        const T& operator[](size_t index) const {
+            return *element(index);
+        }
+    };
+
+    class Branch : public TreeNode {
+    public:
+        size_t child_count = 0;
+        bool leaf_children = true;
+        TreeNode* children[Fanout];
+        size_t counts[Fanout];
+
+        size_t find_child(const TreeNode* child) const {
+            size_t index = 0;
+            while (children[index] != child) {
+                ++index;
+            }
+            return index;
+        }
+        size_t total() const {
+            size_t sum = 0;
+            for (size_t i = 0; i < child_count; ++i) {
+                sum += counts[i];
+            }
+            return sum;
+        }
+    };
+
+    static constexpr size_t min_node_size = NodeMaxSize / 2 > 0 ? NodeMaxSize / 2 : 1;
+    static constexpr size_t min_branch_size = Fanout / 2;
+    // Перенос элемента в другой слот не выбрасывает исключений. Только такие T сдвигаются внутри листа
+    // и перераспределяются между соседними листьями: прерванный посередине сдвиг нельзя ни завершить,
+    // ни откатить
+    static constexpr bool nothrow_relocatable =
+        is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    size_t list_size = 0;
+    Branch* root = nullptr;
+    Node* head = nullptr;
+    Node* tail = nullptr;
+
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    NodeAllocator node_allocator;
+    using BranchAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Branch>;
+    BranchAllocator branch_allocator;
+    using ElementAllocator = std::allocator_traits<Allocator>;
+    Allocator element_allocator;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+    using const_pointer = const T*;
+    using const_reference = const T&;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+
+    template<bool IsConst>
+    class BasicIterator {
+    public:
+        using node_pointer = std::conditional_t<IsConst, const Node*, Node*>;
+
+        node_pointer current_node = nullptr;
+        size_t current_index = 0;
+        const tiered_unrolled_list* owner = nullptr;
+
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
+
+        BasicIterator() = default;
+
+        BasicIterator(node_pointer node, size_t index, const tiered_unrolled_list* owner)
+            : current_node(node), current_index(index), owner(owner) {}
+
+        template<bool OtherConst> requires (IsConst && !OtherConst)
+        BasicIterator(const BasicIterator<OtherConst>& other)
+            : current_node(other.current_node), current_index(other.current_index), owner(other.owner) {}
+
+        reference operator*() const {
+            return (*current_node)[current_index];
+        }
+        pointer operator->() const {
+            return current_node->element(current_index);
+        }
+        BasicIterator& operator++() {
+            if (current_index + 1 >= current_node->node_size) {
+                current_node = current_node->next;
+                current_index = 0;
+            } else {
+                ++current_index;
+            }
+            return *this;
+        }
+        BasicIterator operator++(int) {
+            BasicIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        BasicIterator& operator--() {
+            if (current_node == nullptr) {
+                current_node = owner->tail;
+                current_index = current_node->node_size - 1;
+            } else if (current_index == 0) {
+                current_node = current_node->prev;
+                current_index = current_node->node_size - 1;
+            } else {
+                --current_index;
+            }
+            return *this;
+        }
+        BasicIterator operator--(int) {
+            BasicIterator temp = *this;
+            --(*this);
+            return temp;
+        }
+        bool operator==(const BasicIterator& other) const {
+            return current_node == other.current_node && current_index == other.current_index;
+        }
+        bool operator!=(const BasicIterator& other) const {
+            return !(*this == other);
+        }
+    };
+
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+    using iterator = Iterator;
+    using const_iterator = ConstIterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    tiered_unrolled_list() = default;
+    explicit tiered_unrolled_list(const Allocator& alloc)
+        : node_allocator(alloc), branch_allocator(alloc), element_allocator(alloc) {}
+    tiered_unrolled_list(size_t count, const T& value, const Allocator& alloc = Allocator())
+        : tiered_unrolled_list(alloc) {
+        try {
+            for (size_t i = 0; i < count; ++i) {
+                emplace_back(value);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+    template<typename InputIterator> requires (!std::is_integral_v<InputIterator>)
+    tiered_unrolled_list(InputIterator first, InputIterator last, const Allocator& alloc = Allocator())
+        : tiered_unrolled_list(alloc) {
+        try {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+    tiered_unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : tiered_unrolled_list(init.begin(), init.end(), alloc) {}
+    tiered_unrolled_list(const tiered_unrolled_list& other)
+        : tiered_unrolled_list(other, ElementAllocator::select_on_container_copy_construction(other.element_allocator)) {}
+    tiered_unrolled_list(const tiered_unrolled_list& other, const Allocator& alloc)
+        : tiered_unrolled_list(other.begin(), other.end(), alloc) {}
+    tiered_unrolled_list(tiered_unrolled_list&& other) noexcept
+        : node_allocator(std::move(other.node_allocator)), branch_allocator(std::move(other.branch_allocator)),
+          element_allocator(std::move(other.element_allocator)) {
+        steal_tree(other);
+    }
+    tiered_unrolled_list(tiered_unrolled_list&& other, const Allocator& alloc)
+        : tiered_unrolled_list(alloc) {
+        if (allocators_equal(other)) {
+            steal_tree(other);
+            return;
+        }
+        try {
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+        } catch (...) {
+            clear();
+            throw;
+        }
+        other.clear();
+    }
+
+    ~tiered_unrolled_list() noexcept {
+        clear();
+    }
+
+    static constexpr bool propagate_on_move_assignment =
+        std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value;
+    static constexpr bool allocators_always_equal = std::allocator_traits<NodeAllocator>::is_always_equal::value;
+
+    bool allocators_equal(const tiered_unrolled_list& other) const noexcept {
+        if constexpr (allocators_always_equal) {
+            return true;
+        } else {
+            return node_allocator == other.node_allocator;
+        }
+    }
+    void steal_tree(tiered_unrolled_list& other) noexcept {
+        root = std::exchange(other.root, nullptr);
+        head = std::exchange(other.head, nullptr);
+        tail = std::exchange(other.tail, nullptr);
+        list_size = std::exchange(other.list_size, 0);
+    }
+
+    tiered_unrolled_list& operator=(const tiered_unrolled_list& other) {
+        if (this == &other) {
+            return *this;
+        }
+        tiered_unrolled_list copy(other, std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value
+            ? other.element_allocator : element_allocator);
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value) {
+            clear();
+            node_allocator = other.node_allocator;
+            branch_allocator = other.branch_allocator;
+            element_allocator = other.element_allocator;
+        }
+        swap_tree(copy);
+        return *this;
+    }
+    tiered_unrolled_list& operator=(tiered_unrolled_list&& other)
+        noexcept(propagate_on_move_assignment || allocators_always_equal) {
+        if (this == &other) {
+            return *this;
+        }
+        clear();
+        if constexpr (propagate_on_move_assignment) {
+            node_allocator = std::move(other.node_allocator);
+            branch_allocator = std::move(other.branch_allocator);
+            element_allocator = std::move(other.element_allocator);
+        } else if (!allocators_equal(other)) {
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+            other.clear();
+            return *this;
+        }
+        steal_tree(other);
+        return *this;
+    }
+    tiered_unrolled_list& operator=(std::initializer_list<T> init) {
+        tiered_unrolled_list copy(init, element_allocator);
+        swap_tree(copy);
+        return *this;
+    }
+    void swap_tree(tiered_unrolled_list& other) noexcept {
+        std::swap(root, other.root);
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(list_size, other.list_size);
+    }
+    void swap(tiered_unrolled_list& other) noexcept {
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value) {
+            std::swap(node_allocator, other.node_allocator);
+            std::swap(branch_allocator, other.branch_allocator);
+            std::swap(element_allocator, other.element_allocator);
+        }
+        swap_tree(other);
+    }
+    friend void swap(tiered_unrolled_list& lhs, tiered_unrolled_list& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    bool operator==(const tiered_unrolled_list& other) const {
+        return list_size == other.list_size && std::equal(begin(), end(), other.begin());
+    }
+    bool operator!=(const tiered_unrolled_list& other) const {
+        return !(*this == other);
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return element_allocator;
+    }
+    bool empty() const {
+        return list_size == 0;
+    }
+    size_t size() const {
+        return list_size;
+    }
+    size_t max_size() const {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    iterator begin() {
+        return Iterator(head, 0, this);
+    }
+    iterator end() {
+        return Iterator(nullptr, 0, this);
+    }
+    const_iterator begin() const {
+        return ConstIterator(head, 0, this);
+    }
+    const_iterator end() const {
+        return ConstIterator(nullptr, 0, this);
+    }
+    const_iterator cbegin() const {
+        return begin();
+    }
+    const_iterator cend() const {
+        return end();
+    }
+    reverse_iterator rbegin() {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend() {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const {
+        return rbegin();
+    }
+    const_reverse_iterator crend() const {
+        return rend();
+    }
+
+    reference front() {
+        return (*head)[0];
+    }
+    const_reference front() const {
+        return (*head)[0];
+    }
+    reference back() {
+        return (*tail)[tail->node_size - 1];
+    }
+    const_reference back() const {
+        return (*tail)[tail->node_size - 1];
+    }
+
+    reference operator[](size_t position) {
+        Node* node = locate(position);
+        return (*node)[position];
+    }
+    const_reference operator[](size_t position) const {
+        const Node* node = locate(position);
+        return (*node)[position];
+    }
+    reference at(size_t position) {
+        if (position >= list_size) {
+            throw std::out_of_range("tiered_unrolled_list::at");
+        }
+        return (*this)[position];
+    }
+    const_reference at(size_t position) const {
+        if (position >= list_size) {
+            throw std::out_of_range("tiered_unrolled_list::at");
+        }
+        return (*this)[position];
+    }
+    iterator nth(size_t position) {
+        if (position >= list_size) {
+            return end();
+        }
+        Node* node = locate(position);
+        return Iterator(node, position, this);
+    }
+    const_iterator nth(size_t position) const {
+        if (position >= list_size) {
+            return end();
+        }
+        const Node* node = locate(position);
+        return ConstIterator(node, position, this);
+    }
+    size_t index_of(const_iterator pos) const {
+        if (pos.current_node == nullptr) {
+            return list_size;
+        }
+        size_t position = pos.current_index;
+        const TreeNode* child = pos.current_node;
+        for (const Branch* branch = child->parent; branch; child = branch, branch = branch->parent) {
+            for (size_t i = 0; branch->children[i] != child; ++i) {
+                position += branch->counts[i];
+            }
+        }
+        return position;
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        Iterator it = emplace_in_node(tail, tail ? tail->node_size : 0, std::forward<Args>(args)...);
+        return *it;
+    }
+    template<typename... Args>
+    reference emplace_front(Args&&... args) {
+        Iterator it = emplace_in_node(head, 0, std::forward<Args>(args)...);
+        return *it;
+    }
+    template<typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        if (pos.current_node == nullptr) {
+            return emplace_in_node(tail, tail ? tail->node_size : 0, std::forward<Args>(args)...);
+        }
+        return emplace_in_node(const_cast<Node*>(pos.current_node), pos.current_index, std::forward<Args>(args)...);
+    }
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+    void push_front(const T& value) {
+        emplace_front(value);
+    }
+    void push_front(T&& value) {
+        emplace_front(std::move(value));
+    }
+    iterator insert(const_iterator pos, const T& value) {
+        return emplace(pos, value);
+    }
+    iterator insert(const_iterator pos, T&& value) {
+        return emplace(pos, std::move(value));
+    }
+    // Копии строятся сериями по листу: хвост листа за pos один раз уходит в отдельный лист, копии
+    // дописываются в конец листа перед ним и в новые листья, размеры поддеревьев обновляются один
+    // раз на лист, а недозаполненные листья выравниваются в конце. Если вставка помещается в лист,
+    // его хвост просто сдвигается. При исключении вставленные копии удаляются, и список не меняется
+    iterator insert(const_iterator pos, size_t count, const T& value) {
+        size_t position = index_of(pos);
+        if (count == 0) {
+            return nth(position);
+        }
+        // value может лежать в самом списке и сдвинуться после первой вставки
+        T copy(value);
+        auto construct_copy = [&](T* place) {
+            ElementAllocator::construct(element_allocator, place, copy);
+        };
+        Node* node = const_cast<Node*>(pos.current_node);
+        size_t index = pos.current_index;
+        if constexpr (nothrow_relocatable) {
+            if (node && node->node_size + count <= NodeMaxSize) {
+                shift_within(node, index, index + count, node->node_size - index);
+                try {
+                    construct_run(node, index, count, construct_copy);
+                } catch (...) {
+                    shift_within(node, index + count, index, node->node_size - index);
+                    throw;
+                }
+                node->node_size += count;
+                list_size += count;
+                propagate(node, static_cast<std::ptrdiff_t>(count));
+                return Iterator(node, index, this);
+            }
+        }
+        Node* left = node ? node->prev : tail;
+        Node* suffix = nullptr;
+        if (node && index > 0) {
+            auto construct_nothing = [](T*) {};
+            suffix = move_suffix_to_new_leaf(node, index, 0, construct_nothing);
+            left = node;
+        }
+        const size_t old_size = list_size;
+        try {
+            if (!left && !root) {
+                emplace_back(copy);
+                left = head;
+            } else if (!left) {
+                left = move_suffix_to_new_leaf(head, head->node_size, std::min(count, NodeMaxSize), construct_copy, true);
+            }
+            while (list_size - old_size < count) {
+                size_t remaining = count - (list_size - old_size);
+                if (left->node_size == NodeMaxSize) {
+                    left = move_suffix_to_new_leaf(left, NodeMaxSize, std::min(remaining, NodeMaxSize), construct_copy);
+                    continue;
+                }
+                size_t run = std::min(remaining, NodeMaxSize - left->node_size);
+                construct_run(left, left->node_size, run, construct_copy);
+                left->node_size += run;
+                list_size += run;
+                propagate(left, static_cast<std::ptrdiff_t>(run));
+            }
+        } catch (...) {
+            // Вставленные копии заканчиваются на границе листа, поэтому их удаление ничего не сдвигает
+            erase(nth(position), nth(position + (list_size - old_size)));
+            throw;
+        }
+        // Перебалансировка suffix не освобождает left, поэтому его можно обработать следом
+        if (suffix) {
+            rebalance_node(suffix);
+        }
+        rebalance_node(left);
+        return nth(position);
+    }
+    void pop_back() noexcept {
+        erase_in_node(tail, tail->node_size - 1);
+    }
+    void pop_front() noexcept(nothrow_relocatable) {
+        erase_in_node(head, 0);
+    }
+    // Для T без nothrow_relocatable удаление не с конца листа переносит хвост листа в новый лист
+    // и может выбросить исключение; тогда список не меняется
+    iterator erase(const_iterator pos) noexcept(nothrow_relocatable) {
+        size_t position = index_of(pos);
+        erase_in_node(const_cast<Node*>(pos.current_node), pos.current_index);
+        return nth(position);
+    }
+    // Удаляет элементы сериями по листу: из первого листа хвост, из последнего начало, промежуточные
+    // листья освобождаются целиком. Размеры поддеревьев обновляются один раз на лист, а порог
+    // заполненности восстанавливается в конце только у двух граничных листьев
+    iterator erase(const_iterator first, const_iterator last) noexcept(nothrow_relocatable) {
+        size_t position = index_of(first);
+        size_t count = index_of(last) - position;
+        if (count == 0) {
+            return nth(position);
+        }
+        if constexpr (!nothrow_relocatable) {
+            // Хвост последнего листа за удаляемыми копируется в новый лист до того, как что-либо
+            // разрушается: дальше удаляются только концы листьев и листья целиком, без сдвигов
+            Node* end_node = const_cast<Node*>(last.current_node);
+            if (end_node && last.current_index > 0) {
+                auto construct_nothing = [](T*) {};
+                move_suffix_to_new_leaf(end_node, last.current_index, 0, construct_nothing);
+            }
+        }
+        Node* node = const_cast<Node*>(first.current_node);
+        size_t index = first.current_index;
+        Node* start = index > 0 ? node : nullptr;
+        Node* finish = nullptr;
+        while (count > 0) {
+            size_t run = std::min(count, node->node_size - index);
+            Node* next_node = node->next;
+            erase_run(node, index, run);
+            count -= run;
+            if (node->node_size == 0 && head != tail) {
+                remove_node(node);
+            } else if (node != start) {
+                finish = node;
+            }
+            node = next_node;
+            index = 0;
+        }
+        // Перебалансировка finish не освобождает start, поэтому его можно обработать следом
+        if (finish) {
+            rebalance_node(finish);
+        }
+        if (start) {
+            rebalance_node(start);
+        }
+        return nth(position);
+    }
+    void erase_at(size_t position) noexcept(nothrow_relocatable) {
+        Node* node = locate(position);
+        erase_in_node(node, position);
+    }
+
+    void clear() noexcept {
+        Node* node = head;
+        while (node) {
+            Node* next_node = node->next;
+            for (size_t i = 0; i < node->node_size; ++i) {
+                ElementAllocator::destroy(element_allocator, node->element(i));
+            }
+            deallocate_node(node);
+            node = next_node;
+        }
+        if (root) {
+            destroy_branches(root);
+        }
+        root = nullptr;
+        head = nullptr;
+        tail = nullptr;
+        list_size = 0;
+    }
+
+    // Спуск от корня по размерам поддеревьев. В position остаётся смещение внутри найденной ноды
+    Node* locate(size_t& position) const {
+        const Branch* branch = root;
+        while (true) {
+            size_t child = 0;
+            while (position >= branch->counts[child]) {
+                position -= branch->counts[child];
+                ++child;
+            }
+            if (branch->leaf_children) {
+                return static_cast<Node*>(branch->children[child]);
+            }
+            branch = static_cast<const Branch*>(branch->children[child]);
+        }
+    }
+    // Изменяет размеры всех поддеревьев на пути от node до корня
+    void propagate(TreeNode* node, std::ptrdiff_t delta) noexcept {
+        for (Branch* branch = node->parent; branch; node = branch, branch = branch->parent) {
+            branch->counts[branch->find_child(node)] += delta;
+        }
+    }
+
+    Node* allocate_node() {
+        Node* node = std::allocator_traits<NodeAllocator>::allocate(node_allocator, 1);
+        node->parent = nullptr;
+        node->node_size = 0;
+        node->next = nullptr;
+        node->prev = nullptr;
+        return node;
+    }
+    void deallocate_node(Node* node) noexcept {
+        std::allocator_traits<NodeAllocator>::deallocate(node_allocator, node, 1);
+    }
+    Branch* allocate_branch() {
+        Branch* branch = std::allocator_traits<BranchAllocator>::allocate(branch_allocator, 1);
+        branch->parent = nullptr;
+        branch->child_count = 0;
+        branch->leaf_children = true;
+        return branch;
+    }
+    void deallocate_branch(Branch* branch) noexcept {
+        std::allocator_traits<BranchAllocator>::deallocate(branch_allocator, branch, 1);
+    }
+    void destroy_branches(Branch* branch) noexcept {
+        if (!branch->leaf_children) {
+            for (size_t i = 0; i < branch->child_count; ++i) {
+                destroy_branches(static_cast<Branch*>(branch->children[i]));
+            }
+        }
+        deallocate_branch(branch);
+    }
+
+    // Вершины, нужные для разбиения листа, выделяются заранее, чтобы само разбиение не могло
+    // выбросить исключение на середине
+    struct SplitReserve {
+        static constexpr size_t max_height = std::numeric_limits<size_t>::digits;
+
+        tiered_unrolled_list* list = nullptr;
+        Node* node = nullptr;
+        Branch* branches[max_height];
+        size_t branch_count = 0;
+
+        explicit SplitReserve(tiered_unrolled_list* list) : list(list) {}
+
+        void acquire(const Node* leaf) {
+            size_t needed = 1;
+            const Branch* branch = leaf->parent;
+            while (branch && branch->child_count == Fanout) {
+                ++needed;
+                branch = branch->parent;
+            }
+            if (branch) {
+                --needed;
+            }
+            node = list->allocate_node();
+            for (; branch_count < needed; ++branch_count) {
+                branches[branch_count] = list->allocate_branch();
+            }
+        }
+        Branch* take_branch() noexcept {
+            return branches[--branch_count];
+        }
+        ~SplitReserve() {
+            if (node) {
+                list->deallocate_node(node);
+            }
+            while (branch_count > 0) {
+                list->deallocate_branch(take_branch());
+            }
+        }
+    };
+
+    void shift_within(Node* node, size_t from, size_t to, size_t count) noexcept {
+        static_assert(nothrow_relocatable, "in-leaf shifts require T that can be relocated without throwing");
+        if constexpr (is_trivially_relocatable_v<T>) {
+            std::memmove(static_cast<void*>(node->element(to)), node->element(from), count * sizeof(T));
+        } else if (to < from) {
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::construct(element_allocator, node->element(to + i), std::move((*node)[from + i]));
+                ElementAllocator::destroy(element_allocator, node->element(from + i));
+            }
+        } else {
+            for (size_t i = count; i > 0; --i) {
+                ElementAllocator::construct(element_allocator, node->element(to + i - 1),
+                    std::move((*node)[from + i - 1]));
+                ElementAllocator::destroy(element_allocator, node->element(from + i - 1));
+            }
+        }
+    }
+    // Переносит count элементов из src в dst. Источник разрушается только после того,
+    // как все элементы успешно сконструированы в dst
+    void relocate_between(Node* src, size_t from, Node* dst, size_t to, size_t count)
+        noexcept(nothrow_relocatable) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            std::memcpy(static_cast<void*>(dst->element(to)), src->element(from), count * sizeof(T));
+        } else if constexpr (nothrow_relocatable) {
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::construct(element_allocator, dst->element(to + i), std::move((*src)[from + i]));
+                ElementAllocator::destroy(element_allocator, src->element(from + i));
+            }
+        } else {
+            size_t constructed = 0;
+            try {
+                for (; constructed < count; ++constructed) {
+                    ElementAllocator::construct(element_allocator, dst->element(to + constructed),
+                        std::move_if_noexcept((*src)[from + constructed]));
+                }
+            } catch (...) {
+                for (size_t i = 0; i < constructed; ++i) {
+                    ElementAllocator::destroy(element_allocator, dst->element(to + i));
+                }
+                throw;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::destroy(element_allocator, src->element(from + i));
+            }
+        }
+    }
+    // Строит в новом листе count элементов через construct_next и переносит следом элементы node
+    // с позиции from. Лист встаёт сразу после node, а при before — перед ним (тогда from == node_size).
+    // Исходные элементы разрушаются только после того, как все конструкторы отработали, поэтому при
+    // исключении список не меняется. Требует count + node_size - from <= NodeMaxSize
+    template<typename ConstructNext>
+    Node* move_suffix_to_new_leaf(Node* node, size_t from, size_t count, ConstructNext& construct_next,
+        bool before = false) {
+        SplitReserve reserve(this);
+        reserve.acquire(node);
+        Node* leaf = reserve.node;
+        size_t moved = node->node_size - from;
+        construct_run(leaf, 0, count, construct_next);
+        try {
+            relocate_between(node, from, leaf, count, moved);
+        } catch (...) {
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::destroy(element_allocator, leaf->element(i));
+            }
+            throw;
+        }
+        reserve.node = nullptr;
+        leaf->node_size = count + moved;
+        node->node_size = from;
+        link_leaf(node, leaf, before);
+        insert_child(node->parent, node, leaf, moved, before, reserve);
+        list_size += count;
+        propagate(leaf, static_cast<std::ptrdiff_t>(count));
+        return leaf;
+    }
+    // Вставляет leaf в цепочку листьев сразу после node или, при before, перед ним
+    void link_leaf(Node* node, Node* leaf, bool before) noexcept {
+        if (before) {
+            leaf->next = node;
+            leaf->prev = node->prev;
+            if (node->prev) {
+                node->prev->next = leaf;
+            } else {
+                head = leaf;
+            }
+            node->prev = leaf;
+        } else {
+            leaf->prev = node;
+            leaf->next = node->next;
+            if (node->next) {
+                node->next->prev = leaf;
+            } else {
+                tail = leaf;
+            }
+            node->next = leaf;
+        }
+    }
+
+    template<typename... Args>
+    iterator emplace_in_node(Node* node, size_t index, Args&&... args) {
+        if (!root) {
+            Branch* new_root = allocate_branch();
+            Node* new_node = nullptr;
+            try {
+                new_node = allocate_node();
+                ElementAllocator::construct(element_allocator, new_node->element(0), std::forward<Args>(args)...);
+            } catch (...) {
+                if (new_node) {
+                    deallocate_node(new_node);
+                }
+                deallocate_branch(new_root);
+                throw;
+            }
+            new_node->node_size = 1;
+            new_node->parent = new_root;
+            new_root->children[0] = new_node;
+            new_root->counts[0] = 1;
+            new_root->child_count = 1;
+            root = new_root;
+            head = tail = new_node;
+            list_size = 1;
+            return Iterator(new_node, 0, this);
+        }
+        // Начало листа совпадает с концом предыдущего, куда можно дописать без сдвига
+        if (index == 0 && node->prev && node->prev->node_size < NodeMaxSize) {
+            node = node->prev;
+            index = node->node_size;
+        }
+        if (index == node->node_size && node->node_size < NodeMaxSize) {
+            ElementAllocator::construct(element_allocator, node->element(index), std::forward<Args>(args)...);
+            ++node->node_size;
+            ++list_size;
+            propagate(node, 1);
+            return Iterator(node, index, this);
+        }
+        auto construct_next = [&](T* place) {
+            ElementAllocator::construct(element_allocator, place, std::forward<Args>(args)...);
+        };
+        // За полным последним листом и перед полным первым заводится новый лист, а полный не делится:
+        // иначе последовательные push_back и push_front оставляли бы листья заполненными наполовину
+        if (node->node_size == NodeMaxSize && (index == 0 ? node == head : node == tail && index == NodeMaxSize)) {
+            return Iterator(move_suffix_to_new_leaf(node, NodeMaxSize, 1, construct_next, index == 0), 0, this);
+        }
+        if constexpr (!nothrow_relocatable) {
+            // Элементы в листе не сдвигаются: новый элемент строится в новом листе, а за ним копируется
+            // хвост листа. Аргументы при этом остаются на месте, исходные элементы разрушаются только в конце.
+            // Перед полным листом новый элемент получает отдельный лист, а из неполного при вставке
+            // в начало переезжают все элементы, и опустевший лист удаляется
+            if (index == 0 && node->node_size == NodeMaxSize) {
+                return Iterator(move_suffix_to_new_leaf(node, NodeMaxSize, 1, construct_next, true), 0, this);
+            }
+            Node* leaf = move_suffix_to_new_leaf(node, index, 1, construct_next);
+            if (index == 0) {
+                remove_node(node);
+            }
+            return Iterator(leaf, 0, this);
+        } else {
+            return emplace_shifting(node, index, std::forward<Args>(args)...);
+        }
+    }
+    // Вставка со сдвигом хвоста листа для nothrow_relocatable T. Полный лист сначала делится пополам
+    template<typename... Args>
+    iterator emplace_shifting(Node* node, size_t index, Args&&... args) {
+        // Аргументы могут ссылаться на элементы, которые сдвинутся при разбиении или сдвиге листа
+        alignas(T) unsigned char buffer[sizeof(T)];
+        T* temp = reinterpret_cast<T*>(buffer);
+        ElementAllocator::construct(element_allocator, temp, std::forward<Args>(args)...);
+        try {
+            if (node->node_size == NodeMaxSize) {
+                SplitReserve reserve(this);
+                reserve.acquire(node);
+                Node* right = split_node(node, index, reserve);
+                if (index > node->node_size || node->node_size == NodeMaxSize) {
+                    index -= node->node_size;
+                    node = right;
+                }
+            }
+            shift_within(node, index, index + 1, node->node_size - index);
+            // Тривиально копируемый T переносится его же копированием: побайтовая копия буфера прочитала бы
+            // байты, которые конструктор не записал (пустой класс, выравнивание)
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                ::new (static_cast<void*>(node->element(index))) T(std::move(*temp));
+            } else if constexpr (is_trivially_relocatable_v<T>) {
+                std::memcpy(static_cast<void*>(node->element(index)), static_cast<const void*>(temp), sizeof(T));
+            } else {
+                try {
+                    ElementAllocator::construct(element_allocator, node->element(index), std::move(*temp));
+                } catch (...) {
+                    shift_within(node, index + 1, index, node->node_size - index);
+                    throw;
+                }
+                ElementAllocator::destroy(element_allocator, temp);
+            }
+        } catch (...) {
+            ElementAllocator::destroy(element_allocator, temp);
+            throw;
+        }
+        ++node->node_size;
+        ++list_size;
+        propagate(node, 1);
+        return Iterator(node, index, this);
+    }
+    // Переносит вторую половину полного листа в новый лист из reserve и регистрирует его в родителе.
+    // При NodeMaxSize == 1 половин нет, и место освобождается там, куда пойдёт вставка
+    Node* split_node(Node* node, size_t index, SplitReserve& reserve) noexcept {
+        Node* right = std::exchange(reserve.node, nullptr);
+        const size_t split_pos = NodeMaxSize == 1 ? index : NodeMaxSize / 2;
+        relocate_between(node, split_pos, right, 0, NodeMaxSize - split_pos);
+        right->node_size = NodeMaxSize - split_pos;
+        node->node_size = split_pos;
+        link_leaf(node, right, false);
+        insert_child(node->parent, node, right, right->node_size, false, reserve);
+        return right;
+    }
+    // Вставляет child в branch сразу после соседа left или, при before, перед ним. Размер child вычитается
+    // из размера соседа: элементы child раньше принадлежали его поддереву
+    void insert_child(Branch* branch, TreeNode* left, TreeNode* child, size_t count, bool before,
+        SplitReserve& reserve) noexcept {
+        if (branch->child_count == Fanout) {
+            Branch* sibling = reserve.take_branch();
+            sibling->leaf_children = branch->leaf_children;
+            const size_t split_pos = Fanout / 2;
+            for (size_t i = split_pos; i < Fanout; ++i) {
+                sibling->children[i - split_pos] = branch->children[i];
+                sibling->counts[i - split_pos] = branch->counts[i];
+                sibling->children[i - split_pos]->parent = sibling;
+            }
+            sibling->child_count = Fanout - split_pos;
+            branch->child_count = split_pos;
+            Branch* target = left->parent;
+            insert_child(target, left, child, count, before, reserve);
+            if (!branch->parent) {
+                Branch* new_root = reserve.take_branch();
+                new_root->leaf_children = false;
+                new_root->children[0] = branch;
+                new_root->counts[0] = list_size;
+                new_root->child_count = 1;
+                branch->parent = new_root;
+                root = new_root;
+            }
+            insert_child(branch->parent, branch, sibling, sibling->total(), false, reserve);
+            return;
+        }
+        size_t index = branch->find_child(left);
+        branch->counts[index] -= count;
+        size_t position = before ? index : index + 1;
+        for (size_t i = branch->child_count; i > position; --i) {
+            branch->children[i] = branch->children[i - 1];
+            branch->counts[i] = branch->counts[i - 1];
+        }
+        branch->children[position] = child;
+        branch->counts[position] = count;
+        child->parent = branch;
+        ++branch->child_count;
+    }
+
+    void erase_in_node(Node* node, size_t index) noexcept(nothrow_relocatable) {
+        if constexpr (!nothrow_relocatable) {
+            // Хвост листа за удаляемым копируется в новый лист до того, как элемент разрушается
+            if (index + 1 < node->node_size) {
+                auto construct_nothing = [](T*) {};
+                move_suffix_to_new_leaf(node, index + 1, 0, construct_nothing);
+            }
+        }
+        erase_run(node, index, 1);
+        rebalance_node(node);
+    }
+    // Разрушает count элементов листа с позиции index и закрывает дыру, размеры поддеревьев
+    // обновляются один раз. Для T без nothrow_relocatable удаляемые должны стоять в конце листа
+    void erase_run(Node* node, size_t index, size_t count) noexcept {
+        for (size_t i = index; i < index + count; ++i) {
+            ElementAllocator::destroy(element_allocator, node->element(i));
+        }
+        if constexpr (nothrow_relocatable) {
+            shift_within(node, index + count, index, node->node_size - index - count);
+        }
+        node->node_size -= count;
+        list_size -= count;
+        propagate(node, -static_cast<std::ptrdiff_t>(count));
+    }
+    // Строит count элементов листа начиная с index через construct_next. При исключении уже
+    // построенные разрушаются, и лист остаётся прежним. node_size не меняется
+    template<typename ConstructNext>
+    void construct_run(Node* node, size_t index, size_t count, ConstructNext& construct_next) {
+        size_t constructed = 0;
+        try {
+            for (; constructed < count; ++constructed) {
+                construct_next(node->element(index + constructed));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i) {
+                ElementAllocator::destroy(element_allocator, node->element(index + i));
+            }
+            throw;
+        }
+    }
+    void rebalance_node(Node* node) noexcept {
+        if (node->node_size >= min_node_size) {
+            return;
+        }
+        Branch* parent = node->parent;
+        if (parent == root && parent->child_count == 1) {
+            if (node->node_size == 0) {
+                deallocate_node(node);
+                deallocate_branch(root);
+                root = nullptr;
+                head = tail = nullptr;
+            }
+            return;
+        }
+        if constexpr (!nothrow_relocatable) {
+            if (node->node_size == 0) {
+                remove_node(node);
+            }
+        } else {
+            rebalance_with_neighbours(node);
+        }
+    }
+    // Забирает недостающие до порога элементы у соседнего листа или сливается с ним. Если сосед
+    // не может поделиться, то вместе с node он помещается в один лист
+    void rebalance_with_neighbours(Node* node) noexcept {
+        Branch* parent = node->parent;
+        size_t index = parent->find_child(node);
+        Node* left = index > 0 ? static_cast<Node*>(parent->children[index - 1]) : nullptr;
+        Node* right = index + 1 < parent->child_count ? static_cast<Node*>(parent->children[index + 1]) : nullptr;
+        const size_t need = min_node_size - node->node_size;
+        if (left && left->node_size >= min_node_size + need) {
+            shift_within(node, 0, need, node->node_size);
+            relocate_between(left, left->node_size - need, node, 0, need);
+            left->node_size -= need;
+            node->node_size += need;
+            parent->counts[index - 1] -= need;
+            parent->counts[index] += need;
+        } else if (right && right->node_size >= min_node_size + need) {
+            relocate_between(right, 0, node, node->node_size, need);
+            shift_within(right, need, 0, right->node_size - need);
+            right->node_size -= need;
+            node->node_size += need;
+            parent->counts[index + 1] -= need;
+            parent->counts[index] += need;
+        } else if (left) {
+            relocate_between(node, 0, left, left->node_size, node->node_size);
+            left->node_size += node->node_size;
+            parent->counts[index - 1] += node->node_size;
+            node->node_size = 0;
+            remove_node(node);
+        } else {
+            relocate_between(right, 0, node, node->node_size, right->node_size);
+            node->node_size += right->node_size;
+            parent->counts[index] += right->node_size;
+            right->node_size = 0;
+            remove_node(right);
+        }
+    }
+    // Удаляет пустой лист из цепочки и из родителя
+    void remove_node(Node* node) noexcept {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        } else {
+            tail = node->prev;
+        }
+        Branch* parent = node->parent;
+        remove_child(parent, node);
+        deallocate_node(node);
+        rebalance_branch(parent);
+    }
+    void remove_child(Branch* branch, TreeNode* child) noexcept {
+        size_t index = branch->find_child(child);
+        for (size_t i = index + 1; i < branch->child_count; ++i) {
+            branch->children[i - 1] = branch->children[i];
+            branch->counts[i - 1] = branch->counts[i];
+        }
+        --branch->child_count;
+    }
+    void rebalance_branch(Branch* branch) noexcept {
+        if (branch == root) {
+            if (branch->child_count == 1 && !branch->leaf_children) {
+                root = static_cast<Branch*>(branch->children[0]);
+                root->parent = nullptr;
+                deallocate_branch(branch);
+            }
+            return;
+        }
+        if (branch->child_count >= min_branch_size) {
+            return;
+        }
+        Branch* parent = branch->parent;
+        size_t index = parent->find_child(branch);
+        Branch* left = index > 0 ? static_cast<Branch*>(parent->children[index - 1]) : nullptr;
+        Branch* right = index + 1 < parent->child_count ? static_cast<Branch*>(parent->children[index + 1]) : nullptr;
+        if (left && left->child_count > min_branch_size) {
+            for (size_t i = branch->child_count; i > 0; --i) {
+                branch->children[i] = branch->children[i - 1];
+                branch->counts[i] = branch->counts[i - 1];
+            }
+            --left->child_count;
+            branch->children[0] = left->children[left->child_count];
+            branch->counts[0] = left->counts[left->child_count];
+            branch->children[0]->parent = branch;
+            ++branch->child_count;
+            parent->counts[index - 1] -= branch->counts[0];
+            parent->counts[index] += branch->counts[0];
+        } else if (right && right->child_count > min_branch_size) {
+            branch->children[branch->child_count] = right->children[0];
+            branch->counts[branch->child_count] = right->counts[0];
+            branch->children[branch->child_count]->parent = branch;
+            size_t moved = right->counts[0];
+            ++branch->child_count;
+            remove_child(right, right->children[0]);
+            parent->counts[index + 1] -= moved;
+            parent->counts[index] += moved;
+        } else {
+            Branch* target = left ? left : branch;
+            Branch* source = left ? branch : right;
+            for (size_t i = 0; i < source->child_count; ++i) {
+                target->children[target->child_count] = source->children[i];
+                target->counts[target->child_count] = source->counts[i];
+                target->children[target->child_count]->parent = target;
+                ++target->child_count;
+            }
+            parent->counts[parent->find_child(target)] += parent->counts[parent->find_child(source)];
+            remove_child(parent, source);
+            deallocate_branch(source);
+            rebalance_branch(parent);
+        }
+    }
+};
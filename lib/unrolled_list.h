@@ -1,24 +1,143 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 
-template<typename T, size_t NodeMaxSize = 10, typename Allocator = std::allocator<T>>
+// Тип можно переносить побайтовым копированием с последующим "забыванием" источника.
+// Для своих типов (например, владеющих указателем хэндлов) признак можно включить специализацией
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+inline constexpr size_t cache_line_size = 64;
+
+// На сколько нод вперёд обход с предвыборкой запрашивает память
+inline constexpr size_t default_prefetch_distance = 16;
+
+// Просит процессор подтянуть в кэш все линии объекта, сам объект не читается
+inline void prefetch_lines(const void* address, size_t bytes) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    const char* line = static_cast<const char*>(address);
+    for (size_t offset = 0; offset < bytes; offset += cache_line_size) {
+        __builtin_prefetch(line + offset);
+    }
+#else
+    (void)address;
+    (void)bytes;
+#endif
+}
+
+// Наибольшая вместимость ноды, элементы которой начинаются со StorageOffset-го байта, при которой нода
+// целиком (заголовок и элементы) укладывается в ByteBudget байт. Нода всегда вмещает хотя бы один элемент
+template<typename T, size_t StorageOffset, size_t ByteBudget = 4 * cache_line_size>
+inline constexpr size_t node_capacity_for_offset =
+    ByteBudget > StorageOffset + sizeof(T) ? (ByteBudget - StorageOffset) / sizeof(T) : 1;
+
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+class unrolled_list;
+
+// То же для ноды unrolled_list. Смещение элементов берётся из самой ноды; от вместимости оно
+// не зависит, поэтому измеряется на ноде из одного элемента
+template<typename T, size_t ByteBudget = 4 * cache_line_size>
+inline constexpr size_t node_capacity_for_budget =
+    node_capacity_for_offset<T, unrolled_list<T, 1, std::allocator<T>, 0, false>::node_storage_offset, ByteBudget>;
+
+// NodeMinSize - порог заполненности: нода, ставшая меньше него после удаления, забирает элементы
+// у соседа или сливается с ним. 0 отключает перебалансировку, пустые ноды удаляются всегда.
+// InlineNode - одна нода хранится прямо в объекте списка и используется раньше выделяемых,
+// так что короткие списки не обращаются к аллокатору
+template<typename T, size_t NodeMaxSize = node_capacity_for_budget<T>, typename Allocator = std::allocator<T>,
+    size_t NodeMinSize = NodeMaxSize / 2, bool InlineNode = false>
 class unrolled_list {
+    static_assert(NodeMinSize <= NodeMaxSize / 2, "NodeMinSize must not exceed NodeMaxSize / 2");
+    static_assert(!InlineNode || is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>,
+        "InlineNode requires T that can be relocated without throwing");
+
 public:
 
-    class Node {
+    // Перенос элемента в другой слот не выбрасывает исключений. Только такие T сдвигаются внутри
+    // ноды на месте: прерванный посередине сдвиг нельзя ни завершить, ни откатить
+    static constexpr bool nothrow_relocatable =
+        is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    // Заголовок идёт первым, а нода выровнена по кэш-линии: при обходе метаданные и первые
+    // элементы читаются из одной линии
+    class alignas(cache_line_size) Node {
     public:
-        T arr[NodeMaxSize];
         size_t node_size = 0;
+        size_t start = 0;
         Node* next = nullptr;
         Node* prev = nullptr;
+        size_t index_slot = 0;
+        // Слоты не конструируются вместе с нодой: временем жизни элементов управляет список
+        alignas(T) unsigned char storage[sizeof(T) * NodeMaxSize];
+
+        // storage используется как кольцевой буфер: логический индекс i лежит в слоте (start + i) % NodeMaxSize
+        size_t physical_index(size_t index) const {
+            index += start;
+            return index < NodeMaxSize ? index : index - NodeMaxSize;
+        }
+        T* slot(size_t physical) {
+            return std::launder(reinterpret_cast<T*>(storage)) + physical;
+        }
+        const T* slot(size_t physical) const {
+            return std::launder(reinterpret_cast<const T*>(storage)) + physical;
+        }
+        T* element(size_t index) {
+            return slot(physical_index(index));
+        }
+        const T* element(size_t index) const {
+            return slot(physical_index(index));
+        }
+        T& operator[](size_t index) {
+            return *element(index);
+        }
+        const T& operator[](size_t index) const {
+            return *element(index);
+        }
+        // Число элементов от start до конца storage, остальные лежат с начала storage
+        size_t first_part_size() const {
+            return std::min(node_size, NodeMaxSize - start);
+        }
     };
+    static constexpr size_t node_storage_offset = offsetof(Node, storage);
 
     size_t list_size = 0;
+    size_t node_count = 0;
     Node* head = nullptr;
     Node* tail = nullptr;
 
+    // Освобождённые ноды не сразу возвращаются аллокатору, а складываются в односвязный
+    // список через next, пока их не больше node_cache_limit
+    static constexpr size_t default_node_cache_limit = 4;
+    Node* node_cache = nullptr;
+    size_t node_cache_size = 0;
+    size_t node_cache_limit = default_node_cache_limit;
+
+    struct InlineNodeStorage {
+        Node node;
+        bool used = false;
+    };
+    struct NoInlineNode {};
+    [[no_unique_address]] std::conditional_t<InlineNode, InlineNodeStorage, NoInlineNode> inline_node;
+
     using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
     NodeAllocator node_allocator;
     using ElementAllocator = std::allocator_traits<Allocator>;
@@ -30,38 +149,40 @@ public:
     using reference = T&;
     using const_pointer = const T*;
     using const_reference = const T&;
-    using allocator_type = std::allocator<Node>;
+    using allocator_type = Allocator;
 
-    class Iterator {
+    template<bool IsConst>
+    class BasicIterator {
     public:
-        Node* current_node = nullptr;
+        using node_pointer = std::conditional_t<IsConst, const Node*, Node*>;
+
+        node_pointer current_node = nullptr;
         size_t current_index = 0;
+        // Нужен, чтобы шагнуть назад из end(): у end() нет ноды, а последняя нода есть только у списка
+        const unrolled_list* owner = nullptr;
 
         using iterator_category = std::bidirectional_iterator_tag;
         using value_type = T;
         using difference_type = std::ptrdiff_t;
-        using pointer = T*;
-        using reference = T&;
-        using const_pointer = const T*;
-        using const_reference = const T&;
+        using pointer = std::conditional_t<IsConst, const T*, T*>;
+        using reference = std::conditional_t<IsConst, const T&, T&>;
 
-        explicit Iterator(Node* node) : current_node(node) {}
+        BasicIterator() = default;
 
-        Iterator(Node* node, size_t index) : current_node(node), current_index(index) {}
+        BasicIterator(node_pointer node, size_t index, const unrolled_list* owner)
+            : current_node(node), current_index(index), owner(owner) {}
 
-        reference operator*() {
-            return current_node->arr[current_index];
-        }
-        pointer operator->() {
-            return &(current_node->arr[current_index]);
-        }
-        const_reference operator*() const {
-            return current_node->arr[current_index];
+        template<bool OtherConst> requires (IsConst && !OtherConst)
+        BasicIterator(const BasicIterator<OtherConst>& other)
+            : current_node(other.current_node), current_index(other.current_index), owner(other.owner) {}
+
+        reference operator*() const {
+            return (*current_node)[current_index];
         }
-        const_pointer operator->() const {
-            return current_node->arr[current_index];
+        pointer operator->() const {
+            return current_node->element(current_index);
         }
-        Iterator& operator++() {
+        BasicIterator& operator++() {
             if (current_index + 1 >= current_node->node_size) {
                 current_node = current_node->next;
                 current_index = 0;
@@ -70,13 +191,16 @@ public:
             }
             return *this;
         }
-        Iterator& operator++(int) {
-            Iterator temp = *this;
+        BasicIterator operator++(int) {
+            BasicIterator temp = *this;
             ++(*this);
             return temp;
         }
-        Iterator& operator--() {
-            if (current_index == 0) {
+        BasicIterator& operator--() {
+            if (current_node == nullptr) {
+                current_node = owner->tail;
+                current_index = current_node->node_size - 1;
+            } else if (current_index == 0) {
                 current_node = current_node->prev;
                 current_index = current_node->node_size - 1;
             } else {
@@ -84,48 +208,209 @@ public:
             }
             return *this;
         }
-        Iterator& operator--(int) {
-            Iterator temp = *this;
+        BasicIterator operator--(int) {
+            BasicIterator temp = *this;
             --(*this);
             return temp;
         }
-        bool operator==(const Iterator& other) const {
+        bool operator==(const BasicIterator& other) const {
             return current_node == other.current_node && current_index == other.current_index;
         }
-        bool operator!=(const Iterator& other) const {
+        bool operator!=(const BasicIterator& other) const {
             return !(*this == other);
         }
     };
 
+    using Iterator = BasicIterator<false>;
+    using ConstIterator = BasicIterator<true>;
+
+    // Обход списка непрерывными кусками: нода даёт один std::span, а если её кольцевой буфер
+    // перекинулся через конец storage, то два. Внутри куска алгоритмы работают как с обычным массивом.
+    // При PrefetchDistance > 0 итератор при переходе на ноду запрашивает память ноды на PrefetchDistance
+    // впереди. Её адрес берётся из массива нод индекса позиций, а не по цепочке next: цепочка - это
+    // зависимые загрузки, и через неё больше одного промаха за раз в полёте не держится
+    template<bool IsConst, size_t PrefetchDistance = 0>
+    class BasicSegmentIterator {
+    public:
+        using node_pointer = std::conditional_t<IsConst, const Node*, Node*>;
+        using segment_element = std::conditional_t<IsConst, const T, T>;
+
+        struct PrefetchIndex {
+            Node* const* nodes = nullptr;
+            size_t count = 0;
+        };
+        struct NoPrefetch {};
+
+        node_pointer current_node = nullptr;
+        bool second_part = false;
+        const unrolled_list* owner = nullptr;
+        [[no_unique_address]] std::conditional_t<(PrefetchDistance > 0), PrefetchIndex, NoPrefetch> prefetch_index{};
+
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::span<segment_element>;
+        using difference_type = std::ptrdiff_t;
+
+        BasicSegmentIterator() = default;
+
+        BasicSegmentIterator(node_pointer node, const unrolled_list* owner) : current_node(node), owner(owner) {}
+
+        // Индекс должен быть действителен или пуст (тогда предвыборки нет). Сразу запрашиваются ноды, которые шаги вперёд уже не покроют
+        BasicSegmentIterator(node_pointer node, const unrolled_list* owner, PrefetchIndex index)
+                requires (PrefetchDistance > 0)
+            : current_node(node), owner(owner), prefetch_index(index) {
+            if (node != nullptr) {
+                for (size_t slot = node->index_slot + 1;
+                        slot < std::min(node->index_slot + PrefetchDistance, index.count); ++slot) {
+                    prefetch_lines(index.nodes[slot], sizeof(Node));
+                }
+                prefetch_ahead();
+            }
+        }
+
+        std::span<segment_element> operator*() const {
+            size_t first_size = current_node->first_part_size();
+            if (second_part) {
+                return {current_node->slot(0), current_node->node_size - first_size};
+            }
+            return {current_node->slot(current_node->start), first_size};
+        }
+        BasicSegmentIterator& operator++() {
+            if (!second_part && current_node->first_part_size() < current_node->node_size) {
+                second_part = true;
+            } else {
+                current_node = current_node->next;
+                second_part = false;
+                if constexpr (PrefetchDistance > 0) {
+                    if (current_node != nullptr) {
+                        prefetch_ahead();
+                    }
+                }
+            }
+            return *this;
+        }
+        // Слоты удалённых нод остаются в индексе до перестройки; запрос по такому адресу
+        // ничего не читает и не падает, а только тратит одну предвыборку
+        void prefetch_ahead() const noexcept requires (PrefetchDistance > 0) {
+            size_t slot = current_node->index_slot + PrefetchDistance;
+            if (slot < prefetch_index.count) {
+                prefetch_lines(prefetch_index.nodes[slot], sizeof(Node));
+            }
+        }
+        BasicSegmentIterator operator++(int) {
+            BasicSegmentIterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        // Итератор списка на элемент с номером offset внутри текущего куска
+        BasicIterator<IsConst> position(size_t offset = 0) const {
+            return {current_node, (second_part ? current_node->first_part_size() : 0) + offset, owner};
+        }
+        bool operator==(const BasicSegmentIterator& other) const {
+            return current_node == other.current_node && second_part == other.second_part;
+        }
+    };
+
+    template<bool IsConst>
+    class BasicSegmentView : public std::ranges::view_interface<BasicSegmentView<IsConst>> {
+    public:
+        BasicSegmentIterator<IsConst> first;
+
+        BasicSegmentView() = default;
+
+        BasicSegmentView(typename BasicSegmentIterator<IsConst>::node_pointer head, const unrolled_list* owner)
+            : first(head, owner) {}
+
+        BasicSegmentIterator<IsConst> begin() const {
+            return first;
+        }
+        BasicSegmentIterator<IsConst> end() const {
+            return BasicSegmentIterator<IsConst>();
+        }
+    };
+
+    // Предвыборка начинается в begin(), поэтому повторный обход того же view снова её запускает
+    template<bool IsConst, size_t PrefetchDistance>
+    class BasicPrefetchedSegmentView
+        : public std::ranges::view_interface<BasicPrefetchedSegmentView<IsConst, PrefetchDistance>> {
+    public:
+        using segment_iterator = BasicSegmentIterator<IsConst, PrefetchDistance>;
+
+        typename segment_iterator::node_pointer first = nullptr;
+        const unrolled_list* owner = nullptr;
+        typename segment_iterator::PrefetchIndex index;
+
+        BasicPrefetchedSegmentView() = default;
+
+        BasicPrefetchedSegmentView(typename segment_iterator::node_pointer head, const unrolled_list* owner,
+            typename segment_iterator::PrefetchIndex index) : first(head), owner(owner), index(index) {}
+
+        segment_iterator begin() const {
+            return segment_iterator(first, owner, index);
+        }
+        segment_iterator end() const {
+            return segment_iterator();
+        }
+    };
+
+    using SegmentView = BasicSegmentView<false>;
+    using ConstSegmentView = BasicSegmentView<true>;
+
+    SegmentView segments() {
+        return SegmentView(head, this);
+    }
+    ConstSegmentView segments() const {
+        return ConstSegmentView(head, this);
+    }
+    // Те же куски с предвыборкой нод на PrefetchDistance вперёд, для проходов по большим холодным
+    // спискам. Адреса нод берутся из индекса позиций, поэтому он строится, если ещё не построен.
+    // Константная версия индекс не строит и при сброшенном индексе обходит куски без предвыборки.
+    // Поэлементный обход: prefetched_segments() | std::views::join
+    template<size_t PrefetchDistance = default_prefetch_distance>
+    BasicPrefetchedSegmentView<false, PrefetchDistance> prefetched_segments() {
+        static_assert(PrefetchDistance > 0, "use segments() to iterate without prefetching");
+        if (!index_valid) {
+            index_rebuild();
+        }
+        return {head, this, {index_nodes, index_count}};
+    }
+    template<size_t PrefetchDistance = default_prefetch_distance>
+    BasicPrefetchedSegmentView<true, PrefetchDistance> prefetched_segments() const {
+        static_assert(PrefetchDistance > 0, "use segments() to iterate without prefetching");
+        if (!index_valid) {
+            return {head, this, {}};
+        }
+        return {head, this, {index_nodes, index_count}};
+    }
     using iterator = Iterator;
-    using const_iterator = const Iterator;
+    using const_iterator = ConstIterator;
     using size_type = size_t;
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
     reference front() {
-        return head->arr[0];
+        return (*head)[0];
     }
     reference back() {
-        return tail->arr[tail->node_size - 1];
+        return (*tail)[tail->node_size - 1];
     }
     const_reference front() const{
-        return head->arr[0];
+        return (*head)[0];
     }
     const_reference back() const {
-        return tail->arr[tail->node_size - 1];
+        return (*tail)[tail->node_size - 1];
     }
     reverse_iterator rbegin() {
         return reverse_iterator(end());
     }
     const_reverse_iterator rbegin() const {
-        return reverse_iterator(end());
+        return const_reverse_iterator(end());
     }
     reverse_iterator rend() {
         return reverse_iterator(begin());
     }
     const_reverse_iterator rend() const {
-        return reverse_iterator(begin());
+        return const_reverse_iterator(begin());
     }
     const_reverse_iterator crbegin() const {
         return const_reverse_iterator(end());
@@ -134,22 +419,16 @@ public:
         return const_reverse_iterator(begin());
     }
     iterator begin() {
-        return Iterator(head, 0);
+        return Iterator(head, 0, this);
     }
     iterator end() {
-        if (tail == nullptr) {
-            return Iterator(nullptr);
-        }
-        return Iterator(tail->next);
+        return Iterator(nullptr, 0, this);
     }
     const_iterator begin() const {
-        return Iterator(head, 0);
+        return ConstIterator(head, 0, this);
     }
     const_iterator end() const {
-        if (tail == nullptr) {
-            return Iterator(nullptr);
-        }
-        return Iterator(tail->next);
+        return ConstIterator(nullptr, 0, this);
     }
     const_iterator cbegin() const {
         return begin();
@@ -157,107 +436,540 @@ public:
     const_iterator cend() const {
         return end();
     }
-    bool empty() {
-        if (head == nullptr) {
-            return true;
-        }
-        return false;
+    bool empty() const {
+        return head == nullptr;
     }
-    size_t size() {
+    size_t size() const {
         return list_size;
     }
-    size_t max_size() {
+    size_t max_size() const {
         return std::numeric_limits<size_t>::max();
     }
 
-    unrolled_list() = default;
-    explicit unrolled_list(const allocator_type& alloc) : node_allocator(alloc){}
-    explicit unrolled_list(const Allocator& alloc) : node_allocator(alloc), element_allocator(alloc) {}
-    unrolled_list(size_t count, const T& value) {
-        for (size_t i = 0; i < count; ++i) {
-            push_back(value);
+    struct FillReport {
+        size_t node_count = 0;
+        size_t element_count = 0;
+        // Средняя доля занятых слотов в ноде, от 0 до 1
+        double average_fill = 0;
+    };
+    FillReport fill_report() const noexcept {
+        FillReport report;
+        report.node_count = node_count;
+        report.element_count = list_size;
+        if (node_count > 0) {
+            report.average_fill = static_cast<double>(list_size) / static_cast<double>(node_count * NodeMaxSize);
         }
+        return report;
     }
-    unrolled_list(std::initializer_list<T> init) {
-        for (const auto& item : init) {
-            push_back(item);
+    // Переупаковывает элементы в полностью заполненные ноды за один проход и возвращает лишние ноды аллокатору.
+    // Каждый элемент переносится не больше одного раза. Если перенос T может выбросить исключение,
+    // список остаётся корректным, но упакованным лишь частично
+    void compact() {
+        index_invalidate();
+        for (Node* node = head; node; node = node->next) {
+            while (node->node_size < NodeMaxSize && node->next) {
+                Node* source = node->next;
+                size_t count = std::min(NodeMaxSize - node->node_size, source->node_size);
+                relocate_between(source, 0, node, node->node_size, count);
+                node->node_size += count;
+                source->start = source->physical_index(count);
+                source->node_size -= count;
+                if (source->node_size == 0) {
+                    remove_node(source);
+                }
+            }
         }
+        trim();
     }
-    unrolled_list(const unrolled_list& other) {
-        if (this == &other) {
+    void shrink_to_fit() {
+        compact();
+    }
+    // Заранее выделяет ноды в кэш так, чтобы дописывание в конец до count элементов
+    // не обращалось к аллокатору. Запас живёт в кэше нод и освобождается trim()
+    void reserve(size_t count) {
+        if (count <= list_size) {
             return;
         }
-        node_allocator = other.node_allocator;
-        element_allocator = other.element_allocator;
-        list_size = other.list_size;
-        node_allocator.allocate(list_size/NodeMaxSize);
-        for (size_t i = 0; i < list_size; i++) {
-            this->push_back(other[i]);
+        size_t spare_nodes = node_cache_size;
+        if constexpr (InlineNode) {
+            spare_nodes += inline_node.used ? 0 : 1;
+        }
+        size_t needed = (count - list_size + NodeMaxSize - 1) / NodeMaxSize;
+        if (needed <= spare_nodes) {
+            return;
+        }
+        Node* reserved = nullptr;
+        size_t reserved_count = 0;
+        try {
+            for (; reserved_count < needed - spare_nodes; ++reserved_count) {
+                Node* node = std::allocator_traits<NodeAllocator>::allocate(node_allocator, 1);
+                node->next = reserved;
+                reserved = node;
+            }
+        } catch (...) {
+            while (reserved) {
+                Node* next_node = reserved->next;
+                std::allocator_traits<NodeAllocator>::deallocate(node_allocator, reserved, 1);
+                reserved = next_node;
+            }
+            throw;
+        }
+        while (reserved) {
+            Node* next_node = reserved->next;
+            reserved->next = node_cache;
+            node_cache = reserved;
+            reserved = next_node;
+        }
+        node_cache_size += reserved_count;
+    }
+    void resize(size_t count) {
+        if (count < list_size) {
+            erase(nth(count), end());
+        } else {
+            append_copies(count - list_size);
+        }
+    }
+    void resize(size_t count, const T& value) {
+        if (count < list_size) {
+            erase(nth(count), end());
+        } else {
+            append_copies(count - list_size, value);
+        }
+    }
+    void assign(size_t count, const T& value) {
+        // value может быть элементом самого списка
+        T copy(value);
+        clear();
+        append_copies(count, copy);
+    }
+    template<typename InputIterator> requires (!std::is_integral_v<InputIterator>)
+    void assign(InputIterator first, InputIterator last) {
+        clear();
+        insert(end(), first, last);
+    }
+    void assign(std::initializer_list<T> init) {
+        clear();
+        insert(end(), init);
+    }
+    template<std::ranges::input_range Range>
+    void assign_range(Range&& range) {
+        clear();
+        insert_range(end(), std::forward<Range>(range));
+    }
+    // Дописывает в конец count элементов, построенных из args: сначала в свободные слоты хвоста,
+    // остальные одной заранее выделенной цепочкой нод
+    template<typename... Args>
+    void append_copies(size_t count, const Args&... args) {
+        if (count == 0) {
+            return;
         }
+        index_invalidate();
+        size_t constructed = 0;
+        auto construct_next = [&](T* place) {
+            ElementAllocator::construct(element_allocator, place, args...);
+            ++constructed;
+        };
+        insert_chain(nullptr, 0, count, [&] { return constructed < count; }, construct_next);
     }
-    template <typename InputIterator>
+
+    // Индекс позиций: дерево Фенвика над размерами нод в порядке цепочки. Строится лениво при первом
+    // позиционном обращении, поддерживается за O(log) при вставке и удалении одного элемента
+    // и сбрасывается, когда меняется сама цепочка нод (кроме добавления ноды в конец и удаления пустой).
+    // Константные методы индекс не строят: при сброшенном индексе они идут по цепочке нод, поэтому
+    // одновременные чтения из разных потоков ничего в списке не пишут
+    using NodePointerAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node*>;
+    using SizeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+    Node** index_nodes = nullptr;
+    size_t* index_tree = nullptr;
+    size_t index_capacity = 0;
+    size_t index_count = 0;
+    bool index_valid = false;
+
+    reference operator[](size_t position) {
+        return *nth(position);
+    }
+    const_reference operator[](size_t position) const {
+        return *nth(position);
+    }
+    reference at(size_t position) {
+        if (position >= list_size) {
+            throw std::out_of_range("unrolled_list::at");
+        }
+        return *nth(position);
+    }
+    const_reference at(size_t position) const {
+        if (position >= list_size) {
+            throw std::out_of_range("unrolled_list::at");
+        }
+        return *nth(position);
+    }
+    iterator nth(size_t position) {
+        if (position >= list_size) {
+            return end();
+        }
+        if (!index_valid) {
+            index_rebuild();
+        }
+        size_t slot = index_find(position);
+        return Iterator(index_nodes[slot], position, this);
+    }
+    const_iterator nth(size_t position) const {
+        if (position >= list_size) {
+            return end();
+        }
+        if (!index_valid) {
+            return nth_in_chain(position);
+        }
+        size_t slot = index_find(position);
+        return ConstIterator(index_nodes[slot], position, this);
+    }
+    size_t index_of(const_iterator pos) {
+        if (pos == end()) {
+            return list_size;
+        }
+        if (!index_valid) {
+            index_rebuild();
+        }
+        return index_prefix(pos.current_node->index_slot) + pos.current_index;
+    }
+    size_t index_of(const_iterator pos) const {
+        if (pos == end()) {
+            return list_size;
+        }
+        if (!index_valid) {
+            return index_of_in_chain(pos);
+        }
+        return index_prefix(pos.current_node->index_slot) + pos.current_index;
+    }
+    // Поиск по цепочке нод без индекса за O(N / NodeMaxSize), с ближнего к позиции конца списка
+    const_iterator nth_in_chain(size_t position) const noexcept {
+        if (position < list_size / 2) {
+            const Node* node = head;
+            while (position >= node->node_size) {
+                position -= node->node_size;
+                node = node->next;
+            }
+            return ConstIterator(node, position, this);
+        }
+        size_t from_back = list_size - position;
+        const Node* node = tail;
+        while (from_back > node->node_size) {
+            from_back -= node->node_size;
+            node = node->prev;
+        }
+        return ConstIterator(node, node->node_size - from_back, this);
+    }
+    size_t index_of_in_chain(const_iterator pos) const noexcept {
+        size_t position = pos.current_index;
+        for (const Node* node = head; node != pos.current_node; node = node->next) {
+            position += node->node_size;
+        }
+        return position;
+    }
+    // Сдвиг итератора на n позиций за O(log) вместо поэлементного std::advance
+    iterator advance(const_iterator pos, difference_type n) {
+        return nth(index_of(pos) + n);
+    }
+    const_iterator advance(const_iterator pos, difference_type n) const {
+        return nth(index_of(pos) + n);
+    }
+
+    void index_rebuild() {
+        size_t count = 0;
+        for (const Node* node = head; node; node = node->next) {
+            ++count;
+        }
+        if (count > index_capacity) {
+            size_t capacity = std::max<size_t>(count * 2, 16);
+            NodePointerAllocator pointer_allocator(node_allocator);
+            SizeAllocator size_allocator(node_allocator);
+            Node** nodes = std::allocator_traits<NodePointerAllocator>::allocate(pointer_allocator, capacity);
+            size_t* tree = nullptr;
+            try {
+                tree = std::allocator_traits<SizeAllocator>::allocate(size_allocator, capacity);
+            } catch (...) {
+                std::allocator_traits<NodePointerAllocator>::deallocate(pointer_allocator, nodes, capacity);
+                throw;
+            }
+            index_release();
+            index_nodes = nodes;
+            index_tree = tree;
+            index_capacity = capacity;
+        }
+        size_t slot = 0;
+        for (Node* node = head; node; node = node->next, ++slot) {
+            index_nodes[slot] = node;
+            index_tree[slot] = node->node_size;
+            node->index_slot = slot;
+        }
+        // Построение дерева за линейное время: каждая вершина добавляет свою сумму родителю
+        for (size_t i = 1; i <= count; ++i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= count) {
+                index_tree[parent - 1] += index_tree[i - 1];
+            }
+        }
+        index_count = count;
+        index_valid = true;
+    }
+    void index_release() noexcept {
+        if (index_capacity == 0) {
+            return;
+        }
+        NodePointerAllocator pointer_allocator(node_allocator);
+        SizeAllocator size_allocator(node_allocator);
+        std::allocator_traits<NodePointerAllocator>::deallocate(pointer_allocator, index_nodes, index_capacity);
+        std::allocator_traits<SizeAllocator>::deallocate(size_allocator, index_tree, index_capacity);
+        index_nodes = nullptr;
+        index_tree = nullptr;
+        index_capacity = 0;
+        index_count = 0;
+        index_valid = false;
+    }
+    void index_invalidate() noexcept {
+        index_valid = false;
+    }
+    // Удалённые ноды оставляют в индексе пустые слоты. Перед подсчётом нод по разности слотов
+    // индекс перестраивается без них; ёмкости уже хватает, поэтому перестройка не выделяет память
+    void index_compact() {
+        if (!index_valid || index_count != node_count) {
+            index_rebuild();
+        }
+    }
+    void index_add(const Node* node, std::ptrdiff_t delta) noexcept {
+        if (!index_valid) {
+            return;
+        }
+        for (size_t i = node->index_slot + 1; i <= index_count; i += i & (~i + 1)) {
+            index_tree[i - 1] += delta;
+        }
+    }
+    // Сумма размеров нод в слотах [0, slot)
+    size_t index_prefix(size_t slot) const noexcept {
+        size_t sum = 0;
+        for (size_t i = slot; i > 0; i -= i & (~i + 1)) {
+            sum += index_tree[i - 1];
+        }
+        return sum;
+    }
+    void index_append(Node* node) noexcept {
+        if (!index_valid) {
+            return;
+        }
+        if (index_count == index_capacity) {
+            index_valid = false;
+            return;
+        }
+        size_t i = ++index_count;
+        size_t lowest_bit = i & (~i + 1);
+        index_tree[i - 1] = index_prefix(i - 1) - index_prefix(i - lowest_bit) + node->node_size;
+        index_nodes[i - 1] = node;
+        node->index_slot = i - 1;
+    }
+    // Возвращает слот ноды с элементом на позиции position, в position остаётся смещение внутри ноды.
+    // Индекс должен быть построен
+    size_t index_find(size_t& position) const noexcept {
+        size_t slot = 0;
+        size_t step = 1;
+        while (step * 2 <= index_count) {
+            step *= 2;
+        }
+        for (; step > 0; step /= 2) {
+            if (slot + step <= index_count && index_tree[slot + step - 1] <= position) {
+                slot += step;
+                position -= index_tree[slot - 1];
+            }
+        }
+        return slot;
+    }
+
+    unrolled_list() = default;
+    explicit unrolled_list(const Allocator& alloc) : node_allocator(alloc), element_allocator(alloc) {}
+    explicit unrolled_list(size_t count, const Allocator& alloc = Allocator())
+        : node_allocator(alloc), element_allocator(alloc) {
+        try {
+            append_copies(count);
+        } catch (...) {
+            trim();
+            throw;
+        }
+    }
+    unrolled_list(size_t count, const T& value, const Allocator& alloc = Allocator())
+        : node_allocator(alloc), element_allocator(alloc) {
+        try {
+            append_copies(count, value);
+        } catch (...) {
+            trim();
+            throw;
+        }
+    }
+    unrolled_list(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+        : unrolled_list(init.begin(), init.end(), alloc) {}
+    unrolled_list(const unrolled_list& other)
+        : unrolled_list(other, ElementAllocator::select_on_container_copy_construction(other.element_allocator)) {}
+    unrolled_list(const unrolled_list& other, const Allocator& alloc)
+        : node_allocator(alloc), element_allocator(alloc) {
+        try {
+            for (const Node* node = other.head; node; node = node->next) {
+                append_node_copy(node);
+            }
+        } catch (...) {
+            clear();
+            trim();
+            throw;
+        }
+    }
+    template <typename InputIterator> requires (!std::is_integral_v<InputIterator>)
     unrolled_list(InputIterator begin, InputIterator end, const Allocator& alloc = Allocator())
         : node_allocator(alloc), element_allocator(alloc) {
-        Node* current_node = nullptr;
-        Node* last_allocated_node = nullptr;
-        size_t elements_in_current_node = 0;
         try {
             for (; begin != end; ++begin) {
-                if (!current_node || elements_in_current_node == NodeMaxSize) {
-                    current_node = allocate_node();
-                    elements_in_current_node = 0;
-                    if (last_allocated_node) {
-                        last_allocated_node->next = current_node;
-                    } else {
-                        head = current_node;
-                    }
-                    last_allocated_node = current_node;
-                    tail = current_node;
+                if (!tail || tail->node_size == NodeMaxSize) {
+                    link_after(tail, allocate_node());
                 }
-                ElementAllocator::construct(
-                    element_allocator,
-                    &current_node->arr[elements_in_current_node],
-                    *begin
-                );
-                elements_in_current_node++;
-                ++current_node->node_size;
-                list_size++;
+                ElementAllocator::construct(element_allocator, tail->element(tail->node_size), *begin);
+                ++tail->node_size;
+                ++list_size;
             }
         } catch (...) {
             rollback_after_exception(head, list_size);
+            trim();
+            throw;
+        }
+    }
+    unrolled_list(unrolled_list&& other) noexcept
+        : node_allocator(std::move(other.node_allocator)), element_allocator(std::move(other.element_allocator)) {
+        steal_nodes(other);
+        steal_node_cache(other);
+    }
+    unrolled_list(unrolled_list&& other, const Allocator& alloc)
+        : node_allocator(alloc), element_allocator(alloc) {
+        if (allocators_equal(other)) {
+            steal_nodes(other);
+            return;
+        }
+        try {
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+        } catch (...) {
+            clear();
+            trim();
             throw;
         }
+        other.clear();
     }
-    unrolled_list(unrolled_list&& other, const allocator_type& alloc); // можно не делать
 
     ~unrolled_list() noexcept {
         clear();
+        trim();
+        index_release();
     }
 
     void clear() noexcept {
         Node* current_node = head;
         while(current_node != nullptr) {
             Node* next_node = current_node->next;
-            for (size_t i = 0; i < current_node->node_size; i++) {
-                ElementAllocator::destroy(element_allocator, &(current_node->arr[i]));
-            }
-            node_allocator.deallocate(current_node, 1);
+            destroy_node(current_node);
             current_node = next_node;
         }
         tail = nullptr;
         head = nullptr;
         list_size = 0;
+        index_invalidate();
     }
     allocator_type get_allocator() const noexcept {
-        return node_allocator;
+        return element_allocator;
     }
     Node* allocate_node() {
-        Node* node = std::allocator_traits<NodeAllocator>::allocate(node_allocator, 1);
+        Node* node = nullptr;
+        if constexpr (InlineNode) {
+            if (!inline_node.used) {
+                inline_node.used = true;
+                node = &inline_node.node;
+            }
+        }
+        if (!node && node_cache) {
+            node = node_cache;
+            node_cache = node->next;
+            --node_cache_size;
+        }
+        if (!node) {
+            node = std::allocator_traits<NodeAllocator>::allocate(node_allocator, 1);
+        }
+        ++node_count;
         node->node_size = 0;
+        node->start = 0;
         node->next = nullptr;
+        node->prev = nullptr;
         return node;
     }
+    void deallocate_node(Node* node) noexcept {
+        --node_count;
+        if constexpr (InlineNode) {
+            if (node == &inline_node.node) {
+                inline_node.used = false;
+                return;
+            }
+        }
+        if (node_cache_size < node_cache_limit) {
+            node->next = node_cache;
+            node_cache = node;
+            ++node_cache_size;
+            return;
+        }
+        std::allocator_traits<NodeAllocator>::deallocate(node_allocator, node, 1);
+    }
+    // Возвращает аллокатору все закэшированные ноды
+    void trim() noexcept {
+        while (node_cache) {
+            Node* next_node = node_cache->next;
+            std::allocator_traits<NodeAllocator>::deallocate(node_allocator, node_cache, 1);
+            node_cache = next_node;
+        }
+        node_cache_size = 0;
+    }
+    void set_node_cache_limit(size_t limit) noexcept {
+        node_cache_limit = limit;
+        while (node_cache_size > node_cache_limit) {
+            Node* next_node = node_cache->next;
+            std::allocator_traits<NodeAllocator>::deallocate(node_allocator, node_cache, 1);
+            node_cache = next_node;
+            --node_cache_size;
+        }
+    }
+    // Забирает кэш other вместе с его аллокатором: ноды кэша должен освобождать тот же аллокатор
+    void steal_node_cache(unrolled_list& other) noexcept {
+        node_cache = std::exchange(other.node_cache, nullptr);
+        node_cache_size = std::exchange(other.node_cache_size, 0);
+    }
+    static bool node_owns(const Node* node, const T* element) noexcept {
+        const void* address = element;
+        return !std::less<const void*>()(address, node->storage) &&
+            std::less<const void*>()(address, node->storage + sizeof(node->storage));
+    }
+    // Вставляет node в цепочку сразу после position (в начало, если position == nullptr)
+    void link_after(Node* position, Node* node) noexcept {
+        if (position == tail) {
+            index_append(node);
+        } else {
+            index_invalidate();
+        }
+        node->prev = position;
+        node->next = position ? position->next : head;
+        if (node->next) {
+            node->next->prev = node;
+        } else {
+            tail = node;
+        }
+        if (position) {
+            position->next = node;
+        } else {
+            head = node;
+        }
+    }
     void remove_node(Node* node) {
+        index_add(node, -static_cast<std::ptrdiff_t>(node->node_size));
         if (node->prev) {
             node->prev->next = node->next;
         } else {
@@ -268,407 +980,1863 @@ public:
         } else {
             tail = node->prev;
         }
-        node_allocator.deallocate(node, 1);
+        deallocate_node(node);
     }
     void rollback_after_exception(Node* first_node, size_t elements_to_destroy) {
         Node* current_node = first_node;
         size_t destroyed_elements = 0;
-        while (current_node && destroyed_elements < elements_to_destroy) {
-            for (size_t i = 0; i < current_node->node_size; ++i) {
-                if (destroyed_elements >= elements_to_destroy) break;
-                ElementAllocator::destroy(
-                    element_allocator,
-                    &current_node->arr[i]
-                );
+        while (current_node) {
+            for (size_t i = 0; i < current_node->node_size && destroyed_elements < elements_to_destroy; ++i) {
+                ElementAllocator::destroy(element_allocator, current_node->element(i));
                 destroyed_elements++;
             }
             Node* next_node = current_node->next;
-            std::allocator_traits<NodeAllocator>::deallocate(node_allocator, current_node, 1);
+            deallocate_node(current_node);
             current_node = next_node;
         }
         head = nullptr;
         tail = nullptr;
         list_size = 0;
+        index_invalidate();
     }
 
-    unrolled_list& operator=(std::initializer_list<T> init) {
-        clear();
-        for (const auto& item : init) {
-            push_back(item);
+    // Переносит count элементов ноды с логических позиций [from, from + count) на [to, to + count),
+    // корректно обрабатывая перекрытие диапазонов. Все сдвиги внутри нод проходят через эту функцию
+    void relocate_within(Node* node, size_t from, size_t to, size_t count) noexcept {
+        static_assert(nothrow_relocatable, "in-node shifts require T that can be relocated without throwing");
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (to < from) {
+                while (count > 0) {
+                    size_t src = node->physical_index(from);
+                    size_t dst = node->physical_index(to);
+                    size_t run = std::min({count, NodeMaxSize - src, NodeMaxSize - dst});
+                    std::memmove(static_cast<void*>(node->slot(dst)), node->slot(src), run * sizeof(T));
+                    from += run;
+                    to += run;
+                    count -= run;
+                }
+            } else if (to > from) {
+                while (count > 0) {
+                    size_t src_end = node->physical_index(from + count - 1) + 1;
+                    size_t dst_end = node->physical_index(to + count - 1) + 1;
+                    size_t run = std::min({count, src_end, dst_end});
+                    std::memmove(static_cast<void*>(node->slot(dst_end - run)), node->slot(src_end - run),
+                        run * sizeof(T));
+                    count -= run;
+                }
+            }
+        } else if (to < from) {
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::construct(element_allocator, node->element(to + i), std::move((*node)[from + i]));
+                ElementAllocator::destroy(element_allocator, node->element(from + i));
+            }
+        } else if (to > from) {
+            for (size_t i = count; i > 0; --i) {
+                ElementAllocator::construct(element_allocator, node->element(to + i - 1),
+                    std::move((*node)[from + i - 1]));
+                ElementAllocator::destroy(element_allocator, node->element(from + i - 1));
+            }
         }
-        return *this;
     }
-    unrolled_list& operator=(const unrolled_list& other) {
+    // Переносит count элементов из src в dst. Источник разрушается только после того,
+    // как все элементы успешно сконструированы в dst
+    void relocate_between(Node* src, size_t from, Node* dst, size_t to, size_t count) {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            while (count > 0) {
+                size_t src_begin = src->physical_index(from);
+                size_t dst_begin = dst->physical_index(to);
+                size_t run = std::min({count, NodeMaxSize - src_begin, NodeMaxSize - dst_begin});
+                std::memcpy(static_cast<void*>(dst->slot(dst_begin)), src->slot(src_begin), run * sizeof(T));
+                from += run;
+                to += run;
+                count -= run;
+            }
+        } else {
+            size_t constructed = 0;
+            try {
+                for (; constructed < count; ++constructed) {
+                    ElementAllocator::construct(element_allocator, dst->element(to + constructed),
+                        std::move_if_noexcept((*src)[from + constructed]));
+                }
+            } catch (...) {
+                for (size_t i = 0; i < constructed; ++i) {
+                    ElementAllocator::destroy(element_allocator, dst->element(to + i));
+                }
+                throw;
+            }
+            for (size_t i = 0; i < count; ++i) {
+                ElementAllocator::destroy(element_allocator, src->element(from + i));
+            }
+        }
+    }
+    // Освобождает count слотов на логической позиции index, сдвигая меньшую из частей ноды.
+    // node_size не меняется: вызывающий код конструирует элементы в дыре и сам увеличивает размер.
+    // Для T без nothrow_relocatable допустимы только края ноды, где сдвигать ничего не нужно
+    void open_gap(Node* node, size_t index, size_t count = 1) noexcept {
+        if (index == 0) {
+            node->start = node->physical_index(NodeMaxSize - count);
+        } else if (index == node->node_size) {
+            return;
+        } else if constexpr (nothrow_relocatable) {
+            if (index < node->node_size - index) {
+                node->start = node->physical_index(NodeMaxSize - count);
+                relocate_within(node, count, 0, index);
+            } else {
+                relocate_within(node, index, index + count, node->node_size - index);
+            }
+        }
+    }
+    // Обратная операция к open_gap: схлопывает дыру из count уже разрушенных слотов на позиции index.
+    // node_size к моменту вызова уже не учитывает разрушенные элементы. Ограничение на T то же, что у open_gap
+    void close_gap(Node* node, size_t index, size_t count = 1) noexcept {
+        if (index == 0) {
+            node->start = node->physical_index(count);
+        } else if (index == node->node_size) {
+            return;
+        } else if constexpr (nothrow_relocatable) {
+            if (index < node->node_size - index) {
+                relocate_within(node, 0, count, index);
+                node->start = node->physical_index(count);
+            } else {
+                relocate_within(node, index + count, index, node->node_size - index);
+            }
+        }
+    }
+    // Замена дыры в середине ноды для T без nothrow_relocatable: хвост ноды с позиции from переносится
+    // в новую ноду сразу после count новых элементов, которые строит construct_next. Исходные элементы
+    // хвоста разрушаются только после того, как все конструкторы отработали, поэтому при исключении
+    // список не меняется. Новая нода встаёт в цепочку сразу после node. Требует
+    // count + node_size - from <= NodeMaxSize
+    template<typename ConstructNext>
+    Node* move_suffix_to_new_node(Node* node, size_t from, size_t count, ConstructNext& construct_next) {
+        Node* suffix_node = allocate_node();
+        size_t constructed = 0;
+        try {
+            for (; constructed < count; ++constructed) {
+                construct_next(suffix_node->element(constructed));
+            }
+            relocate_between(node, from, suffix_node, count, node->node_size - from);
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i) {
+                ElementAllocator::destroy(element_allocator, suffix_node->element(i));
+            }
+            deallocate_node(suffix_node);
+            throw;
+        }
+        suffix_node->node_size = count + node->node_size - from;
+        node->node_size = from;
+        list_size += count;
+        link_after(node, suffix_node);
+        index_invalidate();
+        return suffix_node;
+    }
+
+    static constexpr bool propagate_on_move_assignment =
+        std::allocator_traits<NodeAllocator>::propagate_on_container_move_assignment::value;
+    static constexpr bool allocators_always_equal = std::allocator_traits<NodeAllocator>::is_always_equal::value;
+
+    bool allocators_equal(const unrolled_list& other) const noexcept {
+        if constexpr (allocators_always_equal) {
+            return true;
+        } else {
+            return node_allocator == other.node_allocator;
+        }
+    }
+    // Забирает цепочку нод other целиком, other остаётся пустым. Аллокаторы должны совпадать
+    void steal_nodes(unrolled_list& other) noexcept {
+        index_invalidate();
+        other.index_invalidate();
+        head = std::exchange(other.head, nullptr);
+        tail = std::exchange(other.tail, nullptr);
+        list_size = std::exchange(other.list_size, 0);
+        node_count = std::exchange(other.node_count, 0);
+        if constexpr (InlineNode) {
+            // Встроенная нода other остаётся в other: её содержимое переезжает во встроенную ноду this
+            if (other.inline_node.used) {
+                transplant_node(&other.inline_node.node, &inline_node.node);
+                other.inline_node.used = false;
+                inline_node.used = true;
+            }
+        }
+    }
+    // Переселяет содержимое встроенной ноды в обычную, чтобы цепочку можно было отдать другому списку.
+    // Возвращает новую ноду. Индекс позиций остаётся корректным
+    Node* evict_inline_node() {
+        Node* node = allocate_node();
+        Node* inline_ptr = &inline_node.node;
+        transplant_node(inline_ptr, node);
+        deallocate_node(inline_ptr);
+        node->index_slot = inline_ptr->index_slot;
+        if (index_valid) {
+            index_nodes[node->index_slot] = node;
+        }
+        return node;
+    }
+    // Переносит элементы и место в цепочке этого списка из ноды from в ноду to
+    void transplant_node(Node* from, Node* to) noexcept {
+        to->start = 0;
+        relocate_between(from, 0, to, 0, from->node_size);
+        to->node_size = std::exchange(from->node_size, 0);
+        to->next = from->next;
+        to->prev = from->prev;
+        if (to->prev) {
+            to->prev->next = to;
+        } else {
+            head = to;
+        }
+        if (to->next) {
+            to->next->prev = to;
+        } else {
+            tail = to;
+        }
+    }
+
+    unrolled_list& operator=(unrolled_list&& other) noexcept(propagate_on_move_assignment || allocators_always_equal) {
         if (this == &other) {
             return *this;
         }
-        node_allocator = other.node_allocator;
-        element_allocator = other.element_allocator;
-        list_size = other.list_size;
-        node_allocator.allocate(list_size/NodeMaxSize);
-        for (size_t i = 0; i < list_size; i++) {
-            this->push_back(other[i]);
+        clear();
+        if constexpr (propagate_on_move_assignment) {
+            // Массивы индекса выделены старым аллокатором и возвращаются ему до замены
+            trim();
+            index_release();
+            node_allocator = std::move(other.node_allocator);
+            element_allocator = std::move(other.element_allocator);
+            steal_node_cache(other);
+        } else if (!allocators_equal(other)) {
+            // Ноды other выделены чужим аллокатором, который нельзя забрать: переносим поэлементно
+            for (auto& item : other) {
+                emplace_back(std::move(item));
+            }
+            other.clear();
+            return *this;
         }
+        steal_nodes(other);
         return *this;
     }
-    bool operator==(const unrolled_list& other) const {
+    void swap(unrolled_list& other) noexcept {
         if (this == &other) {
-            return true;
+            return;
         }
-        if (list_size != other.list_size) {
-            return false;
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_swap::value) {
+            // Массивы индекса, как и кэш нод, уходят вместе с аллокатором, который их выделил
+            std::swap(node_allocator, other.node_allocator);
+            std::swap(element_allocator, other.element_allocator);
+            std::swap(node_cache, other.node_cache);
+            std::swap(node_cache_size, other.node_cache_size);
+            std::swap(index_nodes, other.index_nodes);
+            std::swap(index_tree, other.index_tree);
+            std::swap(index_capacity, other.index_capacity);
+            std::swap(index_count, other.index_count);
+            std::swap(index_valid, other.index_valid);
         }
-        Node* current_one = head;
-        Node* current_two = other.head;
-        size_t elements_compared = 0;
-        while (current_one != nullptr && current_two != nullptr) {
-            for (size_t j = 0; j < current_one->node_size; ++j) {
-                if (current_one->arr[j] != current_two->arr[j]) {
-                    return false;
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(list_size, other.list_size);
+        std::swap(node_count, other.node_count);
+        index_invalidate();
+        other.index_invalidate();
+        if constexpr (InlineNode) {
+            // После обмена цепочек встроенные ноды оказались в чужих списках и меняются местами
+            bool used = inline_node.used;
+            bool other_used = other.inline_node.used;
+            if (used && other_used) {
+                Node temp;
+                transplant_node(&other.inline_node.node, &temp);
+                other.transplant_node(&inline_node.node, &other.inline_node.node);
+                transplant_node(&temp, &inline_node.node);
+            } else if (other_used) {
+                transplant_node(&other.inline_node.node, &inline_node.node);
+            } else if (used) {
+                other.transplant_node(&inline_node.node, &other.inline_node.node);
+            }
+            inline_node.used = other_used;
+            other.inline_node.used = used;
+        }
+    }
+    friend void swap(unrolled_list& lhs, unrolled_list& rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    unrolled_list& operator=(std::initializer_list<T> init) {
+        assign(init);
+        return *this;
+    }
+    unrolled_list& operator=(const unrolled_list& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (std::allocator_traits<NodeAllocator>::propagate_on_container_copy_assignment::value) {
+            if (!allocators_equal(other)) {
+                // Старые ноды и массивы индекса нельзя вернуть чужому аллокатору, поэтому они
+                // освобождаются до его замены
+                clear();
+                trim();
+                index_release();
+            }
+            node_allocator = other.node_allocator;
+            element_allocator = other.element_allocator;
+        }
+        // Уже выделенные ноды переиспользуются: i-я нода получает содержимое i-й ноды other
+        index_invalidate();
+        Node* node = head;
+        const Node* source = other.head;
+        try {
+            for (; node && source; node = node->next, source = source->next) {
+                assign_node(source, node);
+            }
+            if (node) {
+                tail = node->prev;
+                if (tail) {
+                    tail->next = nullptr;
+                } else {
+                    head = nullptr;
                 }
-                ++elements_compared;
-                if (elements_compared == list_size) {
-                    return true;
+                while (node) {
+                    Node* next_node = node->next;
+                    destroy_node(node);
+                    node = next_node;
                 }
             }
-            current_one = current_one->next;
-            current_two = current_two->next;
+            for (; source; source = source->next) {
+                append_node_copy(source);
+            }
+        } catch (...) {
+            list_size = 0;
+            for (const Node* current = head; current; current = current->next) {
+                list_size += current->node_size;
+            }
+            throw;
+        }
+        list_size = other.list_size;
+        return *this;
+    }
+    // Копирует элементы source в пустую ноду node, начиная с нулевого слота
+    void copy_node(const Node* source, Node* node) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            size_t first_run = std::min(source->node_size, NodeMaxSize - source->start);
+            std::memcpy(static_cast<void*>(node->slot(0)), source->slot(source->start), first_run * sizeof(T));
+            std::memcpy(static_cast<void*>(node->slot(first_run)), source->slot(0),
+                (source->node_size - first_run) * sizeof(T));
+            node->node_size = source->node_size;
+        } else {
+            for (; node->node_size < source->node_size; ++node->node_size) {
+                ElementAllocator::construct(element_allocator, node->element(node->node_size),
+                    (*source)[node->node_size]);
+            }
         }
-        return true;
+    }
+    // Приводит содержимое уже заполненной ноды node к содержимому source
+    void assign_node(const Node* source, Node* node) {
+        size_t common = std::min(source->node_size, node->node_size);
+        for (size_t i = 0; i < common; ++i) {
+            (*node)[i] = (*source)[i];
+        }
+        while (node->node_size > source->node_size) {
+            ElementAllocator::destroy(element_allocator, node->element(node->node_size - 1));
+            --node->node_size;
+        }
+        for (; node->node_size < source->node_size; ++node->node_size) {
+            ElementAllocator::construct(element_allocator, node->element(node->node_size),
+                (*source)[node->node_size]);
+        }
+    }
+    void append_node_copy(const Node* source) {
+        Node* node = allocate_node();
+        try {
+            copy_node(source, node);
+        } catch (...) {
+            destroy_node(node);
+            throw;
+        }
+        link_after(tail, node);
+        list_size += node->node_size;
+    }
+    // Разрушает элементы ноды, не входящей в цепочку, и освобождает её
+    void destroy_node(Node* node) noexcept {
+        for (size_t i = 0; i < node->node_size; ++i) {
+            ElementAllocator::destroy(element_allocator, node->element(i));
+        }
+        deallocate_node(node);
+    }
+    bool operator==(const unrolled_list& other) const {
+        if (this == &other) {
+            return true;
+        }
+        if (list_size != other.list_size) {
+            return false;
+        }
+        return std::equal(begin(), end(), other.begin());
     }
     bool operator!=(const unrolled_list& other) const {
-        return !(this == other);
+        return !(*this == other);
     }
 
-    void push_back(const T& value) {
-        bool new_node_added = false;
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
         Node* new_node = nullptr;
-        if (!head || tail->node_size == NodeMaxSize) {
-            new_node = node_allocator.allocate(1);
-            try {
-                new_node->node_size = 0;
-                new_node->prev = tail;
-                new_node->next = nullptr;
-                if (!head) {
-                    head = new_node;
-                } else {
-                    tail->next = new_node;
-                }
-                tail = new_node;
-                new_node_added = true;
-            } catch (...) {
-                node_allocator.deallocate(new_node, 1);
-                throw;
-            }
+        Node* node = tail;
+        if (!tail || tail->node_size == NodeMaxSize) {
+            new_node = allocate_node();
+            node = new_node;
         }
         try {
-            ElementAllocator::construct(element_allocator, &(tail->arr[tail->node_size]), value);
-            ++tail->node_size;
-            list_size++;
+            ElementAllocator::construct(element_allocator, node->element(node->node_size),
+                std::forward<Args>(args)...);
         } catch (...) {
-            if (new_node_added) {
-                if (tail->prev) {
-                    Node* prev_tail = tail->prev;
-                    prev_tail->next = nullptr;
-                    node_allocator.deallocate(tail, 1);
-                    tail = prev_tail;
-                } else {
-                    node_allocator.deallocate(head, 1);
-                    head = tail = nullptr;
-                }
+            if (new_node) {
+                deallocate_node(new_node);
             }
             throw;
         }
+        if (new_node) {
+            link_after(tail, new_node);
+        }
+        ++node->node_size;
+        index_add(node, 1);
+        ++list_size;
+        return (*node)[node->node_size - 1];
     }
-    void push_front(const T& value) {
-    Node* new_node = nullptr;
-    bool new_node_added = false;
+    template<typename... Args>
+    reference emplace_front(Args&&... args) {
+        Node* new_node = nullptr;
+        Node* node = head;
         if (!head || head->node_size == NodeMaxSize) {
-        new_node = node_allocator.allocate(1);
-            try {
-                new_node->node_size = 0;
-                new_node->prev = nullptr;
-                new_node->next = head;
-                if (head) {
-                head->prev = new_node;
-                } else {
-                tail = new_node;
-                }
-                head = new_node;
-                new_node_added = true;
-                } catch (...) {
-                node_allocator.deallocate(new_node, 1);
-                throw;
-                }
+            new_node = allocate_node();
+            node = new_node;
         }
+        size_t new_start = node->physical_index(NodeMaxSize - 1);
         try {
-            for (size_t i = head->node_size; i > 0; --i) {
-                std::allocator_traits<Allocator>::construct(element_allocator, &head->arr[i],
-                    std::move_if_noexcept(head->arr[i - 1]));
-                std::allocator_traits<Allocator>::destroy(element_allocator,&head->arr[i - 1]);
-            }
-            std::allocator_traits<Allocator>::construct(element_allocator, &head->arr[0], value);
-            ++head->node_size;
-            list_size++;
+            ElementAllocator::construct(element_allocator, node->slot(new_start), std::forward<Args>(args)...);
         } catch (...) {
-            if (new_node_added) {
-                if (head->next) {
-                    head->next->prev = nullptr;
-                } else {
-                    tail = nullptr;
-                }
-                Node* old_head = head;
-                head = head->next;
-                node_allocator.deallocate(old_head, 1);
-            } else {
-                for (size_t i = 0; i < head->node_size - 1; ++i) {
-                    std::allocator_traits<Allocator>::construct(element_allocator, &head->arr[i],
-                        std::move_if_noexcept(head->arr[i + 1]));
-                    std::allocator_traits<Allocator>::destroy(element_allocator, &head->arr[i + 1]);
-                }
-                --head->node_size;
+            if (new_node) {
+                deallocate_node(new_node);
             }
             throw;
         }
-    }
-    void pop_back()  noexcept {
-        if (tail->node_size == 0) {
-            return;
+        if (new_node) {
+            link_after(nullptr, new_node);
         }
-        ElementAllocator::destroy(element_allocator, &(tail->arr[tail->node_size - 1]));
+        node->start = new_start;
+        ++node->node_size;
+        index_add(node, 1);
+        ++list_size;
+        return (*node)[0];
+    }
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+    void push_front(const T& value) {
+        emplace_front(value);
+    }
+    void push_front(T&& value) {
+        emplace_front(std::move(value));
+    }
+    void pop_back() noexcept {
+        ElementAllocator::destroy(element_allocator, tail->element(tail->node_size - 1));
         --tail->node_size;
-        list_size--;
-        if (tail->node_size == 0) {
-            if (tail->prev) {
-                Node* prev_tail = tail->prev;
-                prev_tail->next = nullptr;
-                node_allocator.deallocate(tail, 1);
-                tail = prev_tail;
-            } else {
-                node_allocator.deallocate(head, 1);
-                head = tail = nullptr;
+        index_add(tail, -1);
+        --list_size;
+        rebalance_node(tail, end());
+    }
+    void pop_front() noexcept {
+        ElementAllocator::destroy(element_allocator, head->element(0));
+        head->start = head->physical_index(1);
+        --head->node_size;
+        index_add(head, -1);
+        --list_size;
+        rebalance_node(head, end());
+    }
+    // Для T без nothrow_relocatable удаление из середины ноды переносит её хвост в новую ноду
+    // и может выбросить исключение; тогда список не меняется
+    iterator erase(const_iterator pos) noexcept(nothrow_relocatable) {
+        Node* node = const_cast<Node*>(pos.current_node);
+        size_t index = pos.current_index;
+        if constexpr (!nothrow_relocatable) {
+            if (index > 0 && index + 1 < node->node_size) {
+                return erase_in_middle(node, index, 1);
             }
         }
+        ElementAllocator::destroy(element_allocator, node->element(index));
+        --node->node_size;
+        index_add(node, -1);
+        --list_size;
+        close_gap(node, index);
+        if (index < node->node_size) {
+            return rebalance_node(node, Iterator(node, index, this));
+        }
+        return rebalance_node(node, Iterator(node->next, 0, this));
     }
-    void pop_front() noexcept {
-        if (head->node_size == 0) {
-            return;
+    iterator erase(const_iterator first, const_iterator last) noexcept(nothrow_relocatable) {
+        Node* start_node = const_cast<Node*>(first.current_node);
+        size_t start_index = first.current_index;
+        Node* end_node = const_cast<Node*>(last.current_node);
+        size_t end_index = last.current_index;
+        if (first == last) {
+            return Iterator(end_node, end_index, this);
         }
-        ElementAllocator::destroy(element_allocator, &(head->arr[0]));
-        for (size_t i = 1; i < head->node_size; ++i) {
-            head->arr[i - 1] = std::move(head->arr[i]);
+        if constexpr (!nothrow_relocatable) {
+            if (start_node == end_node && start_index > 0) {
+                return erase_in_middle(start_node, start_index, end_index - start_index);
+            }
         }
-        --head->node_size;
-        list_size--;
-        if (head->node_size == 0) {
-            if (head->next) {
-                Node* prev_head = head->next;
-                prev_head->prev = nullptr;
-                node_allocator.deallocate(head, 1);
-                head = prev_head;
-            } else {
-                node_allocator.deallocate(head, 1);
-                head = tail = nullptr;
+        index_invalidate();
+        if (start_node == end_node) {
+            size_t count = end_index - start_index;
+            for (size_t i = start_index; i < end_index; ++i) {
+                ElementAllocator::destroy(element_allocator, start_node->element(i));
             }
+            start_node->node_size -= count;
+            list_size -= count;
+            close_gap(start_node, start_index, count);
+            if (start_index < start_node->node_size) {
+                return rebalance_node(start_node, Iterator(start_node, start_index, this));
+            }
+            return rebalance_node(start_node, Iterator(start_node->next, 0, this));
+        }
+        for (size_t i = start_index; i < start_node->node_size; ++i) {
+            ElementAllocator::destroy(element_allocator, start_node->element(i));
         }
+        list_size -= start_node->node_size - start_index;
+        start_node->node_size = start_index;
+        Node* current_node = start_node->next;
+        while (current_node != end_node) {
+            Node* next_node = current_node->next;
+            for (size_t i = 0; i < current_node->node_size; ++i) {
+                ElementAllocator::destroy(element_allocator, current_node->element(i));
+            }
+            list_size -= current_node->node_size;
+            remove_node(current_node);
+            current_node = next_node;
+        }
+        if (end_node) {
+            for (size_t i = 0; i < end_index; ++i) {
+                ElementAllocator::destroy(element_allocator, end_node->element(i));
+            }
+            end_node->start = end_node->physical_index(end_index);
+            end_node->node_size -= end_index;
+            list_size -= end_index;
+        }
+        // Перебалансировка start_node не освобождает end_node, поэтому его можно обработать следом
+        Iterator result = rebalance_node(start_node, Iterator(end_node, 0, this));
+        if (end_node) {
+            result = rebalance_node(end_node, result);
+        }
+        return result;
     }
-    iterator erase(iterator pos) noexcept {
-            Node* node = pos.current_node;
-            size_t idx = pos.current_index;
-            ElementAllocator::destroy(element_allocator, &(node->arr[idx]));
-            for (size_t i = idx; i < node->node_size - 1; ++i) {
-                node->arr[i] = std::move_if_noexcept(node->arr[i+1]);
+    // Удаляет count элементов с позиции index (0 < index, index + count < node_size) для T без
+    // nothrow_relocatable: хвост за удаляемыми переносится в новую ноду до того, как они разрушаются
+    iterator erase_in_middle(Node* node, size_t index, size_t count) {
+        auto construct_nothing = [](T*) {};
+        Node* suffix_node = move_suffix_to_new_node(node, index + count, 0, construct_nothing);
+        for (size_t i = index; i < index + count; ++i) {
+            ElementAllocator::destroy(element_allocator, node->element(i));
+        }
+        node->node_size = index;
+        list_size -= count;
+        return Iterator(suffix_node, 0, this);
+    }
+    // Восстанавливает порог заполненности node после удаления: сливает её с соседом, если суммарно
+    // они помещаются в одну ноду, иначе забирает недостающие элементы у соседа. Перенос элементов
+    // выполняется только если он не может выбросить исключение. Возвращает новое положение
+    // элемента, на который указывал tracked (tracked не может указывать в пустую ноду)
+    Iterator rebalance_node(Node* node, Iterator tracked) noexcept {
+        if (node->node_size == 0) {
+            remove_node(node);
+            return tracked;
+        }
+        if constexpr (NodeMinSize == 0 || !(is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>)) {
+            return tracked;
+        }
+        if (node->node_size >= NodeMinSize) {
+            return tracked;
+        }
+        Node* prev = node->prev;
+        Node* next = node->next;
+        if (prev && prev->node_size + node->node_size <= NodeMaxSize) {
+            size_t offset = prev->node_size;
+            size_t count = node->node_size;
+            relocate_between(node, 0, prev, offset, count);
+            prev->node_size += count;
+            index_add(prev, count);
+            index_add(node, -static_cast<std::ptrdiff_t>(count));
+            node->node_size = 0;
+            remove_node(node);
+            if (tracked.current_node == node) {
+                return Iterator(prev, offset + tracked.current_index, this);
             }
-            --node->node_size;
-            list_size--;
-            if (node->node_size == 0) {
-                if (node->prev) {
-                    node->prev->next = node->next;
-                } else {
-                    head = node->next;
+            return tracked;
+        }
+        if (next && next->node_size + node->node_size <= NodeMaxSize) {
+            size_t count = node->node_size;
+            next->start = next->physical_index(NodeMaxSize - count);
+            relocate_between(node, 0, next, 0, count);
+            next->node_size += count;
+            index_add(next, count);
+            index_add(node, -static_cast<std::ptrdiff_t>(count));
+            node->node_size = 0;
+            remove_node(node);
+            if (tracked.current_node == node) {
+                return Iterator(next, tracked.current_index, this);
+            }
+            if (tracked.current_node == next) {
+                return Iterator(next, tracked.current_index + count, this);
+            }
+            return tracked;
+        }
+        // Слить не удалось, значит у соседа больше NodeMaxSize - NodeMinSize элементов,
+        // и после передачи недостающих он сам останется не меньше порога
+        size_t count = NodeMinSize - node->node_size;
+        if (prev) {
+            size_t from = prev->node_size - count;
+            open_gap(node, 0, count);
+            relocate_between(prev, from, node, 0, count);
+            prev->node_size -= count;
+            node->node_size += count;
+            index_add(prev, -static_cast<std::ptrdiff_t>(count));
+            index_add(node, count);
+            if (tracked.current_node == node) {
+                return Iterator(node, tracked.current_index + count, this);
+            }
+            if (tracked.current_node == prev && tracked.current_index >= from) {
+                return Iterator(node, tracked.current_index - from, this);
+            }
+            return tracked;
+        }
+        if (next) {
+            size_t offset = node->node_size;
+            relocate_between(next, 0, node, offset, count);
+            next->start = next->physical_index(count);
+            next->node_size -= count;
+            node->node_size += count;
+            index_add(next, -static_cast<std::ptrdiff_t>(count));
+            index_add(node, count);
+            if (tracked.current_node == next) {
+                if (tracked.current_index < count) {
+                    return Iterator(node, offset + tracked.current_index, this);
                 }
-                if (node->next) {
-                    node->next->prev = node->prev;
-                } else {
-                    tail = node->prev;
+                return Iterator(next, tracked.current_index - count, this);
+            }
+        }
+        return tracked;
+    }
+    // Переносит вторую половину полной ноды в новую ноду, вставленную сразу после неё
+    Node* split_node(Node* node) {
+        return split_node_at(node, NodeMaxSize / 2);
+    }
+    // Переносит элементы node начиная с index (0 < index < node_size) в новую ноду сразу после неё.
+    // Если перенос не удался, список не меняется
+    Node* split_node_at(Node* node, size_t index) {
+        Node* new_node = allocate_node();
+        try {
+            relocate_between(node, index, new_node, 0, node->node_size - index);
+        } catch (...) {
+            deallocate_node(new_node);
+            throw;
+        }
+        new_node->node_size = node->node_size - index;
+        node->node_size = index;
+        link_after(node, new_node);
+        index_invalidate();
+        return new_node;
+    }
+
+    // Переносит элементы [first, last) из other перед pos, перецепляя целые ноды: копируются только
+    // элементы граничных нод, которые приходится разрезать. other должен быть другим списком.
+    // При неравных аллокаторах элементы переносятся поэлементно
+    void splice(const_iterator pos, unrolled_list& other, const_iterator first, const_iterator last) {
+        if (first == last) {
+            return;
+        }
+        if (!allocators_equal(other)) {
+            insert(pos, std::make_move_iterator(Iterator(const_cast<Node*>(first.current_node), first.current_index, &other)),
+                std::make_move_iterator(Iterator(const_cast<Node*>(last.current_node), last.current_index, &other)));
+            other.erase(first, last);
+            return;
+        }
+        Node* first_node = const_cast<Node*>(first.current_node);
+        Node* last_node = const_cast<Node*>(last.current_node);
+        size_t moved;
+        size_t moved_nodes;
+        if (first_node == other.head && first.current_index == 0 && last_node == nullptr) {
+            moved = other.list_size;
+            moved_nodes = other.node_count;
+        } else {
+            other.index_compact();
+            moved = other.index_of(last) - other.index_of(first);
+            size_t last_slot = last_node ? last_node->index_slot : other.index_count;
+            moved_nodes = last_slot - first_node->index_slot + (last.current_index > 0 ? 1 : 0);
+        }
+        // Сначала все разрезания: каждое может выбросить исключение, но не меняет содержимое списков
+        Node* position = const_cast<Node*>(pos.current_node);
+        Node* before = position ? position->prev : tail;
+        if (position && pos.current_index > 0) {
+            split_node_at(position, pos.current_index);
+            before = position;
+        }
+        if (last_node && last.current_index > 0) {
+            last_node = other.split_node_at(last_node, last.current_index);
+        }
+        if (first.current_index > 0) {
+            first_node = other.split_node_at(first_node, first.current_index);
+        }
+        if constexpr (InlineNode) {
+            // Встроенная нода other не может перейти в этот список. Выселяется после разрезаний,
+            // так как они могли занять её под новую ноду
+            Node* inline_ptr = &other.inline_node.node;
+            if (other.inline_node.used) {
+                Node* replacement = other.evict_inline_node();
+                if (first_node == inline_ptr) {
+                    first_node = replacement;
                 }
-                node_allocator.deallocate(node, 1);
-                if (head) {
-                    return Iterator(head,0);
-                } else {
-                    return end();
+                if (last_node == inline_ptr) {
+                    last_node = replacement;
                 }
             }
-            if (idx < node->node_size) {
-                return Iterator(node, idx);
-            } else if (node->next) {
-                return Iterator(node->next, 0);
-            } else {
-                return end();
+        }
+        Node* range_tail = last_node ? last_node->prev : other.tail;
+        if (first_node->prev) {
+            first_node->prev->next = last_node;
+        } else {
+            other.head = last_node;
+        }
+        if (last_node) {
+            last_node->prev = first_node->prev;
+        } else {
+            other.tail = first_node->prev;
+        }
+        Node* after = before ? before->next : head;
+        first_node->prev = before;
+        range_tail->next = after;
+        if (before) {
+            before->next = first_node;
+        } else {
+            head = first_node;
+        }
+        if (after) {
+            after->prev = range_tail;
+        } else {
+            tail = range_tail;
+        }
+        other.list_size -= moved;
+        other.node_count -= moved_nodes;
+        list_size += moved;
+        node_count += moved_nodes;
+        index_invalidate();
+        other.index_invalidate();
+    }
+    void splice(const_iterator pos, unrolled_list&& other, const_iterator first, const_iterator last) {
+        splice(pos, other, first, last);
+    }
+    void splice(const_iterator pos, unrolled_list& other) {
+        splice(pos, other, other.begin(), other.end());
+    }
+    void splice(const_iterator pos, unrolled_list&& other) {
+        splice(pos, other);
+    }
+    void concat(unrolled_list& other) {
+        splice(end(), other);
+    }
+    void concat(unrolled_list&& other) {
+        splice(end(), other);
+    }
+    // Отрезает элементы [pos, end()) в новый список с тем же аллокатором
+    unrolled_list split_at(const_iterator pos) {
+        unrolled_list result(element_allocator);
+        if (pos == end()) {
+            return result;
+        }
+        Node* node = const_cast<Node*>(pos.current_node);
+        index_compact();
+        size_t position = index_of(pos);
+        size_t moved_nodes = index_count - node->index_slot;
+        bool inline_moved = false;
+        if constexpr (InlineNode) {
+            size_t inline_slot = inline_node.node.index_slot;
+            inline_moved = inline_node.used && (inline_slot > node->index_slot ||
+                (inline_slot == node->index_slot && pos.current_index == 0));
+        }
+        if (pos.current_index > 0) {
+            node = split_node_at(node, pos.current_index);
+        }
+        if constexpr (InlineNode) {
+            // Встроенная нода из отрезаемой части, в том числе занятая разрезанием, заменяется обычной
+            if (inline_moved || node == &inline_node.node) {
+                Node* replacement = evict_inline_node();
+                if (node == &inline_node.node) {
+                    node = replacement;
+                }
             }
+        }
+        result.head = node;
+        result.tail = tail;
+        tail = node->prev;
+        if (tail) {
+            tail->next = nullptr;
+        } else {
+            head = nullptr;
+        }
+        node->prev = nullptr;
+        result.list_size = list_size - position;
+        result.node_count = moved_nodes;
+        list_size = position;
+        node_count -= moved_nodes;
+        index_invalidate();
+        return result;
     }
-    iterator erase(iterator first, iterator last) noexcept {
-        if (first == last) {
-            return first;
+
+    // Удаление за один проход: оставшиеся элементы сдвигаются к началу через границы нод,
+    // а освободившийся хвост разрушается одним erase. Возвращают количество удалённых элементов
+    size_t remove(const T& value) {
+        for (const Node* node = head; node; node = node->next) {
+            if (node_owns(node, std::addressof(value))) {
+                // value может быть перезаписан при уплотнении
+                T temp_value = value;
+                return remove(temp_value);
+            }
         }
-        Node* start_node = first.current_node;
-        size_t start_idx = first.current_index;
-        Node* end_node = last.current_node;
-        size_t end_idx = last.current_index;
-        if (start_node == end_node) {
-            for (size_t i = start_idx; i < end_idx; ++i) {
-                std::destroy_at(&start_node->arr[i]);
-            }
-            size_t shift_count = start_node->node_size - end_idx;
-            for (size_t i = start_idx; i < start_idx + shift_count; ++i) {
-                start_node->arr[i] = std::move(start_node->arr[end_idx + i - start_idx]);
-            }
-            start_node->node_size -= (end_idx - start_idx);
-            list_size -= (end_idx - start_idx);
-            if (start_node->node_size == 0) {
-                remove_node(start_node);
-                if (start_node->next) {
-                    return Iterator(start_node->next, 0);
-                } else {
-                    return end();
+        return remove_if([&value](const T& element) { return element == value; });
+    }
+    template<typename Predicate>
+    size_t remove_if(Predicate pred) {
+        return compact_if([&pred](const T*, const T& element) { return static_cast<bool>(pred(element)); });
+    }
+    size_t unique() {
+        return unique(std::equal_to<>());
+    }
+    template<typename BinaryPredicate>
+    size_t unique(BinaryPredicate pred) {
+        return compact_if([&pred](const T* kept, const T& element) {
+            return kept && static_cast<bool>(pred(*kept, element));
+        });
+    }
+    // discard получает последний оставленный элемент (nullptr, пока таких нет) и текущий.
+    // Если discard или присваивание выбросят исключение, удаляются только уже пройденные отброшенные
+    // элементы, остальные остаются на местах
+    template<typename Discard>
+    size_t compact_if(Discard discard) {
+        Node* write_node = head;
+        size_t write_index = 0;
+        Node* read_node = head;
+        size_t read_index = 0;
+        const T* kept = nullptr;
+        try {
+            for (; read_node; read_node = read_node->next, read_index = 0) {
+                for (; read_index < read_node->node_size; ++read_index) {
+                    T& element = (*read_node)[read_index];
+                    if (discard(kept, element)) {
+                        continue;
+                    }
+                    T& target = (*write_node)[write_index];
+                    if (&target != &element) {
+                        target = std::move(element);
+                    }
+                    kept = &target;
+                    if (++write_index == write_node->node_size) {
+                        write_node = write_node->next;
+                        write_index = 0;
+                    }
                 }
             }
-            return Iterator(start_node, start_idx);
+        } catch (...) {
+            erase(ConstIterator(write_node, write_index, this), ConstIterator(read_node, read_index, this));
+            throw;
+        }
+        size_t old_size = list_size;
+        erase(ConstIterator(write_node, write_index, this), end());
+        return old_size - list_size;
+    }
+
+    // Сортировка без перецепления отдельных элементов: каждая нода сортируется на месте как массив,
+    // затем отсортированные ноды сливаются восходящим слиянием цепочек. Гарантия basic: при исключении
+    // все элементы остаются в списке, порядок не определён
+    void sort() {
+        sort(std::less<>());
+    }
+    template<typename Compare>
+    void sort(Compare comp) {
+        sort_nodes<false>(comp);
+    }
+    void stable_sort() {
+        stable_sort(std::less<>());
+    }
+    template<typename Compare>
+    void stable_sort(Compare comp) {
+        sort_nodes<true>(comp);
+    }
+    // Сливает отсортированный other в этот список, other становится пустым. Равные элементы
+    // этого списка идут раньше элементов other
+    void merge(unrolled_list& other) {
+        merge(other, std::less<>());
+    }
+    void merge(unrolled_list&& other) {
+        merge(other, std::less<>());
+    }
+    template<typename Compare>
+    void merge(unrolled_list&& other, Compare comp) {
+        merge(other, comp);
+    }
+    template<typename Compare>
+    void merge(unrolled_list& other, Compare comp) {
+        if (&other == this || other.empty()) {
+            return;
         }
-        for (size_t i = start_idx; i < start_node->node_size; ++i) {
-            std::destroy_at(&start_node->arr[i]);
+        if (!allocators_equal(other)) {
+            unrolled_list moved(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()),
+                element_allocator);
+            other.clear();
+            merge(moved, comp);
+            return;
+        }
+        if constexpr (InlineNode) {
+            if (other.inline_node.used) {
+                other.evict_inline_node();
             }
-        size_t removed_from_start = start_node->node_size - start_idx;
-        start_node->node_size = start_idx;
-        for (size_t i = 0; i < end_idx; ++i) {
-            std::destroy_at(&end_node->arr[i]);
         }
-        size_t removed_from_end = end_idx;
-        Node* current_node = start_node->next;
-        while (current_node != end_node) {
-            Node* next_node = current_node->next;
-            remove_node(current_node);
-            current_node = next_node;
+        NodeChain first{head, tail};
+        NodeChain second{std::exchange(other.head, nullptr), std::exchange(other.tail, nullptr)};
+        list_size += std::exchange(other.list_size, 0);
+        node_count += std::exchange(other.node_count, 0);
+        other.index_invalidate();
+        index_invalidate();
+        try {
+            merge_chains(first, second, comp);
+        } catch (...) {
+            head = first.head;
+            tail = first.tail;
+            throw;
+        }
+        head = first.head;
+        tail = first.tail;
+    }
+
+    // Цепочка нод, временно отцепленная от списка на время сортировки
+    struct NodeChain {
+        Node* head = nullptr;
+        Node* tail = nullptr;
+    };
+    static void append_chain(NodeChain& to, NodeChain from) noexcept {
+        if (!from.head) {
+            return;
         }
-        list_size -= (removed_from_start + removed_from_end);
-        if (start_node->node_size == 0) {
-            remove_node(start_node);
-            if (start_node->next) {
-                return Iterator(start_node->next, 0);
+        if (to.tail) {
+            to.tail->next = from.head;
+            from.head->prev = to.tail;
+        } else {
+            to.head = from.head;
+        }
+        to.tail = from.tail;
+    }
+    // Делает элементы ноды непрерывными, начиная с нулевого слота. Возвращает ноду с элементами:
+    // для T без nothrow_relocatable они могут переехать в новую ноду на месте node
+    Node* linearize_node(Node* node) {
+        if (node->start + node->node_size <= NodeMaxSize) {
+            return node;
+        }
+        // Начало кольца сдвигается вплотную к хвосту, после чего остаётся повернуть непрерывный отрезок
+        size_t gap = NodeMaxSize - node->node_size;
+        if (gap > 0) {
+            if constexpr (nothrow_relocatable) {
+                size_t head_count = NodeMaxSize - node->start;
+                node->start = node->physical_index(NodeMaxSize - gap);
+                relocate_within(node, gap, 0, head_count);
             } else {
-                return end();
+                auto construct_nothing = [](T*) {};
+                Node* copy = move_suffix_to_new_node(node, 0, 0, construct_nothing);
+                remove_node(node);
+                return copy;
             }
         }
-        if (end_node->node_size == 0) {
-            remove_node(end_node);
-            return Iterator(end_node->next, 0);
-        }
-        return Iterator(end_node, 0);
+        std::rotate(node->slot(0), node->slot(node->start), node->slot(node->node_size));
+        node->start = 0;
+        return node;
     }
-    Iterator insert(Iterator pos, const T& value) {
-        T temp_value = value;
-        size_t original_list_size = list_size;
-        Node* original_head = head;
-        Node* original_tail = tail;
+    template<bool Stable, typename Compare>
+    void sort_nodes(Compare& comp) {
+        if (list_size < 2) {
+            return;
+        }
+        for (Node* node = head; node; node = node->next) {
+            node = linearize_node(node);
+            T* first = node->slot(node->start);
+            if constexpr (Stable) {
+                std::stable_sort(first, first + node->node_size, comp);
+            } else {
+                std::sort(first, first + node->node_size, comp);
+            }
+        }
+        index_invalidate();
+        // bins[i] хранит слитую цепочку примерно из 2^i исходных нод, младшие корзины содержат более поздние ноды
+        constexpr size_t bin_count = std::numeric_limits<size_t>::digits;
+        NodeChain bins[bin_count];
+        size_t used_bins = 0;
+        NodeChain carry;
+        Node* rest = head;
         try {
-            if (pos == end()) {
-                push_back(temp_value);
-                return Iterator(tail, tail->node_size - 1);
+            while (rest) {
+                carry = {rest, rest};
+                rest = rest->next;
+                carry.head->next = nullptr;
+                if (rest) {
+                    rest->prev = nullptr;
+                }
+                size_t bin = 0;
+                for (; bin < used_bins && bins[bin].head; ++bin) {
+                    merge_chains(bins[bin], carry, comp);
+                    carry = std::exchange(bins[bin], NodeChain{});
+                }
+                bins[bin] = std::exchange(carry, NodeChain{});
+                used_bins = std::max(used_bins, bin + 1);
             }
-            Node* node = pos.current_node;
-            size_t index = pos.current_index;
-            if (node->node_size == NodeMaxSize) {
-                Node* new_node = node_allocator.allocate(1);
-                std::allocator_traits<NodeAllocator>::construct(node_allocator, new_node);
-                const size_t split_pos = NodeMaxSize / 2;
-                for (size_t i = split_pos; i < NodeMaxSize; ++i) {
-                    new_node->arr[i - split_pos] = std::move_if_noexcept(node->arr[i]);
-                    node->arr[i].~T();
+            for (size_t bin = 0; bin < used_bins; ++bin) {
+                merge_chains(bins[bin], carry, comp);
+                carry = std::exchange(bins[bin], NodeChain{});
+            }
+        } catch (...) {
+            // Всё, что успело разойтись по корзинам, собирается обратно в одну цепочку
+            NodeChain all;
+            for (size_t bin = 0; bin < used_bins; ++bin) {
+                append_chain(all, bins[bin]);
+            }
+            append_chain(all, carry);
+            if (rest) {
+                Node* rest_tail = rest;
+                while (rest_tail->next) {
+                    rest_tail = rest_tail->next;
+                }
+                append_chain(all, {rest, rest_tail});
+            }
+            head = all.head;
+            tail = all.tail;
+            throw;
+        }
+        head = carry.head;
+        tail = carry.tail;
+    }
+    // Сливает отсортированные цепочки first и second в first, second становится пустой. Элементы переносятся
+    // блоками в заново заполняемые ноды, а опустевшие ноды источников сразу идут под результат, так что
+    // сверх исходных нод держится не больше одной. При исключении first содержит все элементы обеих цепочек
+    template<typename Compare>
+    void merge_chains(NodeChain& first, NodeChain& second, Compare& comp) {
+        if (!second.head) {
+            return;
+        }
+        if (!first.head || !comp((*second.head)[0], (*first.tail)[first.tail->node_size - 1])) {
+            append_chain(first, std::exchange(second, NodeChain{}));
+            return;
+        }
+        NodeChain result;
+        Node* output = nullptr;
+        Node* spare = nullptr;
+        try {
+            while (first.head && second.head) {
+                if (!output || output->node_size == NodeMaxSize) {
+                    if (output) {
+                        append_chain(result, {output, output});
+                    }
+                    if (spare) {
+                        output = std::exchange(spare, nullptr);
+                        output->start = 0;
+                        output->next = nullptr;
+                        output->prev = nullptr;
+                    } else {
+                        output = allocate_node();
+                    }
                 }
-                new_node->node_size = NodeMaxSize - split_pos;
-                node->node_size = split_pos;
-                new_node->next = node->next;
-                new_node->prev = node;
-                if (node->next) node->next->prev = new_node;
-                node->next = new_node;
-                if (index >= split_pos) {
-                node = new_node;
-                index -= split_pos;
+                Node* left = first.head;
+                Node* right = second.head;
+                size_t room = NodeMaxSize - output->node_size;
+                // Переносится сразу вся серия элементов одной ноды, идущих раньше головы другой
+                Node* source = left;
+                size_t count = 1;
+                if (comp((*right)[0], (*left)[0])) {
+                    source = right;
+                    while (count < room && count < right->node_size && comp((*right)[count], (*left)[0])) {
+                        ++count;
+                    }
+                } else {
+                    while (count < room && count < left->node_size && !comp((*right)[0], (*left)[count])) {
+                        ++count;
+                    }
+                }
+                relocate_between(source, 0, output, output->node_size, count);
+                output->node_size += count;
+                source->start = source->physical_index(count);
+                source->node_size -= count;
+                if (source->node_size == 0) {
+                    NodeChain& chain = source == left ? first : second;
+                    chain.head = source->next;
+                    if (chain.head) {
+                        chain.head->prev = nullptr;
+                    } else {
+                        chain.tail = nullptr;
+                    }
+                    if (spare) {
+                        deallocate_node(source);
+                    } else {
+                        spare = source;
+                    }
                 }
             }
-            for (size_t i = node->node_size; i > index; --i) {
-                node->arr[i] = std::move_if_noexcept(node->arr[i - 1]);
+        } catch (...) {
+            if (output && output->node_size == 0) {
+                deallocate_node(output);
+            } else if (output) {
+                append_chain(result, {output, output});
+            }
+            if (spare) {
+                deallocate_node(spare);
             }
-            new (&node->arr[index]) T(std::move(temp_value));
+            append_chain(result, first);
+            append_chain(result, std::exchange(second, NodeChain{}));
+            first = result;
+            throw;
+        }
+        append_chain(result, {output, output});
+        if (spare) {
+            deallocate_node(spare);
+        }
+        append_chain(result, first);
+        append_chain(result, std::exchange(second, NodeChain{}));
+        first = result;
+    }
+    template<typename... Args>
+    Iterator emplace(const_iterator pos, Args&&... args) {
+        if (pos == end()) {
+            emplace_back(std::forward<Args>(args)...);
+            return Iterator(tail, tail->node_size - 1, this);
+        }
+        Node* node = const_cast<Node*>(pos.current_node);
+        size_t index = pos.current_index;
+        if (index == 0 && node->node_size < NodeMaxSize) {
+            size_t new_start = node->physical_index(NodeMaxSize - 1);
+            ElementAllocator::construct(element_allocator, node->slot(new_start), std::forward<Args>(args)...);
+            node->start = new_start;
             ++node->node_size;
+            index_add(node, 1);
             ++list_size;
-            return Iterator(node, index);
-        } catch (...) {
-            if (list_size != original_list_size) {
-                head = original_head;
-                tail = original_tail;
-                list_size = original_list_size;
+            return Iterator(node, 0, this);
+        }
+        if (index == 0 && node->prev && node->prev->node_size < NodeMaxSize) {
+            node = node->prev;
+            ElementAllocator::construct(element_allocator, node->element(node->node_size),
+                std::forward<Args>(args)...);
+            ++node->node_size;
+            index_add(node, 1);
+            ++list_size;
+            return Iterator(node, node->node_size - 1, this);
+        }
+        if constexpr (!nothrow_relocatable) {
+            if (index > 0) {
+                // Хвост ноды копируется в новую ноду следом за новым элементом, аргументы при этом
+                // остаются на месте: исходные элементы разрушаются только в конце
+                auto construct_next = [&](T* place) {
+                    ElementAllocator::construct(element_allocator, place, std::forward<Args>(args)...);
+                };
+                return Iterator(move_suffix_to_new_node(node, index, 1, construct_next), 0, this);
+            }
+        }
+        // Элемент сначала строится во временном буфере: аргументы могут ссылаться на элементы,
+        // которые сдвинутся при разбиении ноды или открытии дыры. До этого момента список не менялся
+        alignas(T) unsigned char buffer[sizeof(T)];
+        T* temp = reinterpret_cast<T*>(buffer);
+        ElementAllocator::construct(element_allocator, temp, std::forward<Args>(args)...);
+        try {
+            if (node->node_size == NodeMaxSize) {
+                Node* new_node = split_node(node);
+                if (index > node->node_size) {
+                    index -= node->node_size;
+                    node = new_node;
+                }
             }
+            open_gap(node, index);
+        } catch (...) {
+            ElementAllocator::destroy(element_allocator, temp);
             throw;
         }
+        // Тривиально копируемый T переносится его же копированием: побайтовая копия буфера прочитала бы
+        // байты, которые конструктор не записал (пустой класс, выравнивание)
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            ::new (static_cast<void*>(node->element(index))) T(std::move(*temp));
+        } else if constexpr (is_trivially_relocatable_v<T>) {
+            std::memcpy(static_cast<void*>(node->element(index)), static_cast<const void*>(temp), sizeof(T));
+        } else {
+            try {
+                ElementAllocator::construct(element_allocator, node->element(index), std::move(*temp));
+            } catch (...) {
+                close_gap(node, index);
+                ElementAllocator::destroy(element_allocator, temp);
+                throw;
+            }
+            ElementAllocator::destroy(element_allocator, temp);
+        }
+        ++node->node_size;
+        index_add(node, 1);
+        ++list_size;
+        return Iterator(node, index, this);
     }
-    Iterator insert(Iterator pos, size_t count, const T& value) {
+    Iterator insert(const_iterator pos, const T& value) {
+        return emplace(pos, value);
+    }
+    Iterator insert(const_iterator pos, T&& value) {
+        return emplace(pos, std::move(value));
+    }
+    Iterator insert(const_iterator pos, size_t count, const T& value) {
+        Node* node = const_cast<Node*>(pos.current_node);
+        size_t index = pos.current_index;
         if (count == 0) {
-            return pos;
+            return Iterator(node, index, this);
+        }
+        index_invalidate();
+        if (node && node->node_size + count <= NodeMaxSize && node_owns(node, std::addressof(value))) {
+            // value будет сдвинут вместе с остальными элементами ноды
+            T temp_value = value;
+            return insert(pos, count, temp_value);
+        }
+        size_t constructed = 0;
+        auto construct_next = [&](T* place) {
+            ElementAllocator::construct(element_allocator, place, value);
+            ++constructed;
+        };
+        if (node && node->node_size + count <= NodeMaxSize) {
+            return insert_in_node(node, index, count, construct_next);
+        }
+        return insert_chain(node, index, count, [&] { return constructed < count; }, construct_next);
+    }
+    template<typename InputIterator> requires (!std::is_integral_v<InputIterator>)
+    Iterator insert(const_iterator pos, InputIterator first, InputIterator last) {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                typename std::iterator_traits<InputIterator>::iterator_category>) {
+            return insert_sequence(pos, first, last, static_cast<size_t>(std::distance(first, last)));
+        } else {
+            return insert_sequence(pos, std::move(first), std::move(last), unknown_count);
+        }
+    }
+    Iterator insert(const_iterator pos, std::initializer_list<T> init) {
+        return insert_sequence(pos, init.begin(), init.end(), init.size());
+    }
+    template<std::ranges::input_range Range>
+    Iterator insert_range(const_iterator pos, Range&& range) {
+        if constexpr (std::ranges::forward_range<Range> || std::ranges::sized_range<Range>) {
+            return insert_sequence(pos, std::ranges::begin(range), std::ranges::end(range),
+                static_cast<size_t>(std::ranges::distance(range)));
+        } else {
+            return insert_sequence(pos, std::ranges::begin(range), std::ranges::end(range), unknown_count);
+        }
+    }
+    template<std::ranges::input_range Range>
+    void append_range(Range&& range) {
+        insert_range(end(), std::forward<Range>(range));
+    }
+    template<std::ranges::input_range Range>
+    void prepend_range(Range&& range) {
+        insert_range(begin(), std::forward<Range>(range));
+    }
+
+    static constexpr size_t unknown_count = std::numeric_limits<size_t>::max();
+
+    // Вставляет перед pos элементы [first, last). count - их число или unknown_count для
+    // однопроходных диапазонов. Диапазон не должен ссылаться на элементы самого списка
+    template<typename InputIterator, typename Sentinel>
+    Iterator insert_sequence(const_iterator pos, InputIterator first, Sentinel last, size_t count) {
+        Node* node = const_cast<Node*>(pos.current_node);
+        size_t index = pos.current_index;
+        if (first == last) {
+            return Iterator(node, index, this);
+        }
+        index_invalidate();
+        auto construct_next = [&](T* place) {
+            ElementAllocator::construct(element_allocator, place, *first);
+            ++first;
+        };
+        if (count != unknown_count && node && node->node_size + count <= NodeMaxSize) {
+            return insert_in_node(node, index, count, construct_next);
+        }
+        return insert_chain(node, index, count == unknown_count ? 0 : count,
+            [&] { return first != last; }, construct_next);
+    }
+    // Вставляет count элементов в дыру на позиции index ноды, в которой для них хватает места
+    template<typename ConstructNext>
+    Iterator insert_in_node(Node* node, size_t index, size_t count, ConstructNext& construct_next) {
+        if constexpr (!nothrow_relocatable) {
+            if (index > 0 && index < node->node_size) {
+                return Iterator(move_suffix_to_new_node(node, index, count, construct_next), 0, this);
+            }
+        }
+        open_gap(node, index, count);
+        size_t constructed = 0;
+        try {
+            for (; constructed < count; ++constructed) {
+                construct_next(node->element(index + constructed));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < constructed; ++i) {
+                ElementAllocator::destroy(element_allocator, node->element(index + i));
+            }
+            close_gap(node, index, count);
+            throw;
         }
-        size_t original_list_size = list_size;
-        Node* original_head = head;
-        Node* original_tail = tail;
+        node->node_size += count;
+        list_size += count;
+        return Iterator(node, index, this);
+    }
+    // Новые элементы сначала занимают свободные слоты ноды, за которой встаёт вставка (хвоста при вставке
+    // в конец, предыдущей ноды при вставке в начало ноды), а остаток собирается в отдельную цепочку
+    // полностью заполненных нод. Всё это становится частью списка только после того, как все
+    // конструкторы отработали. Ноды под оставшиеся из expected_count элементы выделяются заранее,
+    // дальше цепочка растёт по мере надобности
+    template<typename HasNext, typename ConstructNext>
+    Iterator insert_chain(Node* node, size_t index, size_t expected_count, HasNext has_next,
+            ConstructNext& construct_next) {
+        Node* suffix_node = nullptr;
+        Node* chain_head = nullptr;
+        Node* chain_tail = nullptr;
+        Node* fill_node = node ? (index == 0 ? node->prev : nullptr) : tail;
+        size_t filled = 0;
+        size_t constructed = 0;
+        auto append_chain_node = [&] {
+            Node* new_node = allocate_node();
+            new_node->prev = chain_tail;
+            if (chain_tail) {
+                chain_tail->next = new_node;
+            } else {
+                chain_head = new_node;
+            }
+            chain_tail = new_node;
+        };
         try {
-            Node* node = pos.current_node;
-            size_t index = pos.current_index;
-            if (pos == end()) {
-                for (size_t i = 0; i < count; ++i) {
-                    push_back(value);
+            if (fill_node) {
+                for (; fill_node->node_size + filled < NodeMaxSize && has_next(); ++filled) {
+                    construct_next(fill_node->element(fill_node->node_size + filled));
                 }
-                return Iterator(end());
+                expected_count -= std::min(expected_count, filled);
+            }
+            if (node && index > 0) {
+                suffix_node = allocate_node();
             }
-            if (node->node_size + count <= NodeMaxSize) {
-                for (size_t i = node->node_size; i > index; --i) {
-                    node->arr[i+count-1] = std::move_if_noexcept(node->arr[i-1]);
+            for (size_t i = 0; i < (expected_count + NodeMaxSize - 1) / NodeMaxSize; ++i) {
+                append_chain_node();
+            }
+            Node* current = chain_head;
+            while (has_next()) {
+                if (current && current->node_size == NodeMaxSize) {
+                    current = current->next;
                 }
-                for (size_t i = 0; i < count; ++i) {
-                    ElementAllocator::construct(element_allocator, &node->arr[index+i], value);
+                if (!current) {
+                    append_chain_node();
+                    current = chain_tail;
                 }
-                node->node_size += count;
-                list_size += count;
-                return Iterator(node, index);
-            }
-            size_t need_to_move = node->node_size - index;
-            Node* new_node = node_allocator.allocate(1);
-            new_node->node_size = need_to_move;
-            new_node->prev = node;
-            if (node->next) {
-                node->next->prev = new_node;
-                new_node->next = node->next;
-            } else {
-                tail = new_node;
-                new_node->next = nullptr;
-            }
-            node->next = new_node;
-            for (size_t i = 0; i < need_to_move; i++) {
-                new_node->arr[need_to_move-1-i] = std::move_if_noexcept(node->arr[node->node_size - 1 - i]);
-                ElementAllocator::destroy(element_allocator,
-                &node->arr[node->node_size - 1 - i]);
+                construct_next(current->element(current->node_size));
+                ++current->node_size;
+                ++constructed;
             }
-            for (size_t i = 0; i < count; i++) {
-                ElementAllocator::construct(element_allocator, &node->arr[index+i], value);
+            if (suffix_node) {
+                relocate_between(node, index, suffix_node, 0, node->node_size - index);
             }
-            node->node_size = NodeMaxSize;
-            list_size += count;
-            return Iterator(node, index);
         } catch (...) {
-            if (list_size != original_list_size) {
-                head = original_head;
-                tail = original_tail;
-                list_size = original_list_size;
+            while (chain_head) {
+                Node* next_node = chain_head->next;
+                destroy_node(chain_head);
+                chain_head = next_node;
+            }
+            if (suffix_node) {
+                deallocate_node(suffix_node);
+            }
+            for (size_t i = 0; i < filled; ++i) {
+                ElementAllocator::destroy(element_allocator, fill_node->element(fill_node->node_size + i));
             }
             throw;
         }
+        Iterator result = filled > 0 ? Iterator(fill_node, fill_node->node_size, this) :
+            Iterator(chain_head, 0, this);
+        if (fill_node) {
+            fill_node->node_size += filled;
+            list_size += filled;
+        }
+        if (!chain_head) {
+            return result;
+        }
+        Node* position = node ? node->prev : tail;
+        if (suffix_node) {
+            suffix_node->node_size = node->node_size - index;
+            node->node_size = index;
+            link_after(node, suffix_node);
+            position = node;
+        }
+        chain_head->prev = position;
+        chain_tail->next = position ? position->next : head;
+        if (chain_tail->next) {
+            chain_tail->next->prev = chain_tail;
+        } else {
+            tail = chain_tail;
+        }
+        if (position) {
+            position->next = chain_head;
+        } else {
+            head = chain_head;
+        }
+        list_size += constructed;
+        return result;
     }
 };
+
+// Аналоги std::erase и std::erase_if, находятся через ADL
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename U>
+size_t erase(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, const U& value) {
+    // value может лежать в самом списке (erase(list, list.front())) и быть перезаписан при уплотнении
+    if constexpr (std::is_same_v<T, U>) {
+        return list.remove(value);
+    } else if constexpr (std::is_copy_constructible_v<U>) {
+        U copy(value);
+        return list.remove_if([&copy](const T& element) { return element == copy; });
+    } else {
+        return list.remove_if([&value](const T& element) { return element == value; });
+    }
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Predicate>
+size_t erase_if(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Predicate pred) {
+    return list.remove_if(pred);
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define UNROLLED_LIST_X86_SIMD 1
+#else
+#define UNROLLED_LIST_X86_SIMD 0
+#endif
+
+// Уровень векторизации ядер поиска и свёртки. Выбирается по процессору при первом обращении,
+// set_simd_level может его понизить (например, чтобы в тестах пройти все реализации), но не поднять
+enum class simd_level { scalar, sse2, avx2 };
+
+namespace simd_kernels {
+
+inline simd_level detect_level() noexcept {
+#if UNROLLED_LIST_X86_SIMD
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? simd_level::avx2 : simd_level::sse2;
+#else
+    return simd_level::scalar;
+#endif
+}
+inline std::atomic<simd_level>& level_storage() noexcept {
+    static std::atomic<simd_level> level(detect_level());
+    return level;
+}
+
+// Типы, для которых есть векторные ядра. bool и long double обрабатываются скалярным кодом
+template<typename T>
+inline constexpr bool supported = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> &&
+    (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8);
+
+// Целые суммируются в 64 битах по модулю 2^64, как последовательное сложение в long long
+template<typename T>
+using sum_type = std::conditional_t<std::is_floating_point_v<T>, T,
+    std::conditional_t<std::is_signed_v<T>, long long, unsigned long long>>;
+
+template<typename T>
+size_t find_scalar(const T* data, size_t size, T value) noexcept {
+    return std::find(data, data + size, value) - data;
+}
+template<typename T>
+size_t count_scalar(const T* data, size_t size, T value) noexcept {
+    return std::count(data, data + size, value);
+}
+template<typename T>
+sum_type<T> sum_scalar(const T* data, size_t size) noexcept {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::accumulate(data, data + size, T());
+    } else {
+        unsigned long long result = 0;
+        for (size_t i = 0; i < size; ++i) {
+            result += static_cast<unsigned long long>(data[i]);
+        }
+        return static_cast<sum_type<T>>(result);
+    }
+}
+
+#if UNROLLED_LIST_X86_SIMD
+
+// Ядра написаны на векторных расширениях GCC/Clang один раз для ширины Bytes и встраиваются
+// в обёртки с нужным target, так что один и тот же код собирается и под SSE2, и под AVX2
+template<typename T, size_t Bytes>
+struct vector {
+    typedef T type __attribute__((vector_size(Bytes)));
+};
+template<typename T, size_t Bytes>
+using vector_t = typename vector<T, Bytes>::type;
+
+template<size_t Bytes, typename Mask>
+[[gnu::always_inline]] inline bool any_lane(const Mask& mask) noexcept {
+    vector_t<unsigned long long, Bytes> words;
+    std::memcpy(&words, &mask, Bytes);
+    unsigned long long result = 0;
+    for (size_t i = 0; i < Bytes / 8; ++i) {
+        result |= words[i];
+    }
+    return result != 0;
+}
+
+template<size_t Bytes, typename T>
+[[gnu::always_inline]] inline size_t find_kernel(const T* data, size_t size, T value) noexcept {
+    using Vector = vector_t<T, Bytes>;
+    constexpr size_t lanes = Bytes / sizeof(T);
+    Vector needle = Vector{} + value;
+    size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+        Vector block;
+        std::memcpy(&block, data + i, Bytes);
+        if (any_lane<Bytes>(block == needle)) {
+            break;
+        }
+    }
+    return i + find_scalar(data + i, size - i, value);
+}
+
+template<size_t Bytes, typename T>
+[[gnu::always_inline]] inline size_t count_kernel(const T* data, size_t size, T value) noexcept {
+    using Vector = vector_t<T, Bytes>;
+    using Mask = decltype(Vector{} == Vector{});
+    constexpr size_t lanes = Bytes / sizeof(T);
+    // Совпадение даёт в маске -1, счётчики в узких дорожках сбрасываются, пока не переполнились
+    constexpr size_t flush_period = 127;
+    Vector needle = Vector{} + value;
+    size_t result = 0;
+    size_t i = 0;
+    while (i + lanes <= size) {
+        Mask counters{};
+        for (size_t step = 0; step < flush_period && i + lanes <= size; ++step, i += lanes) {
+            Vector block;
+            std::memcpy(&block, data + i, Bytes);
+            counters -= (block == needle);
+        }
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            result += static_cast<size_t>(counters[lane]);
+        }
+    }
+    return result + count_scalar(data + i, size - i, value);
+}
+
+template<size_t Bytes, typename T>
+[[gnu::always_inline]] inline sum_type<T> sum_kernel(const T* data, size_t size) noexcept {
+    // Целые расширяются до 64 бит порциями, которые после расширения занимают ровно один регистр
+    using Accumulator = std::conditional_t<std::is_floating_point_v<T>, T, unsigned long long>;
+    constexpr size_t lanes = Bytes / sizeof(Accumulator);
+    using Chunk = vector_t<T, lanes * sizeof(T)>;
+    using AccumulatorVector = vector_t<Accumulator, Bytes>;
+    AccumulatorVector total{};
+    size_t i = 0;
+    for (; i + lanes <= size; i += lanes) {
+        Chunk chunk;
+        std::memcpy(&chunk, data + i, sizeof(chunk));
+        total += __builtin_convertvector(chunk, AccumulatorVector);
+    }
+    Accumulator result{};
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        result += total[lane];
+    }
+    return static_cast<sum_type<T>>(result + static_cast<Accumulator>(sum_scalar(data + i, size - i)));
+}
+
+// Наименьшее (Max == false) или наибольшее значение непустого куска. Для чисел с плавающей точкой
+// выставляет unordered, если встретился NaN: тогда порядок std::min_element векторно не воспроизвести
+template<size_t Bytes, bool Max, typename T>
+[[gnu::always_inline]] inline T extremum_kernel(const T* data, size_t size, bool& unordered) noexcept {
+    using Vector = vector_t<T, Bytes>;
+    using Mask = decltype(Vector{} == Vector{});
+    constexpr size_t lanes = Bytes / sizeof(T);
+    T result = data[0];
+    size_t i = 0;
+    if (size >= lanes) {
+        Vector best;
+        std::memcpy(&best, data, Bytes);
+        Mask nan{};
+        for (i = lanes; i + lanes <= size; i += lanes) {
+            Vector block;
+            std::memcpy(&block, data + i, Bytes);
+            if constexpr (std::is_floating_point_v<T>) {
+                nan |= block != block;
+            }
+            if constexpr (Max) {
+                best = best < block ? block : best;
+            } else {
+                best = block < best ? block : best;
+            }
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            nan |= best != best;
+            unordered = unordered || any_lane<Bytes>(nan);
+        }
+        result = best[0];
+        for (size_t lane = 1; lane < lanes; ++lane) {
+            result = Max ? std::max(result, best[lane]) : std::min(result, best[lane]);
+        }
+    }
+    for (; i < size; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            unordered = unordered || data[i] != data[i];
+        }
+        result = Max ? std::max(result, data[i]) : std::min(result, data[i]);
+    }
+    return result;
+}
+
+template<typename T>
+[[gnu::target("avx2")]] size_t find_avx2(const T* data, size_t size, T value) noexcept {
+    return find_kernel<32>(data, size, value);
+}
+template<typename T>
+[[gnu::target("avx2")]] size_t count_avx2(const T* data, size_t size, T value) noexcept {
+    return count_kernel<32>(data, size, value);
+}
+template<typename T>
+[[gnu::target("avx2")]] sum_type<T> sum_avx2(const T* data, size_t size) noexcept {
+    return sum_kernel<32>(data, size);
+}
+template<bool Max, typename T>
+[[gnu::target("avx2")]] T extremum_avx2(const T* data, size_t size, bool& unordered) noexcept {
+    return extremum_kernel<32, Max>(data, size, unordered);
+}
+
+#endif
+
+// Точки входа выбирают реализацию по текущему уровню
+template<typename T>
+size_t find(const T* data, size_t size, T value) noexcept {
+#if UNROLLED_LIST_X86_SIMD
+    switch (level_storage().load(std::memory_order_relaxed)) {
+    case simd_level::avx2:
+        return find_avx2(data, size, value);
+    case simd_level::sse2:
+        return find_kernel<16>(data, size, value);
+    default:
+        break;
+    }
+#endif
+    return find_scalar(data, size, value);
+}
+template<typename T>
+size_t count(const T* data, size_t size, T value) noexcept {
+#if UNROLLED_LIST_X86_SIMD
+    switch (level_storage().load(std::memory_order_relaxed)) {
+    case simd_level::avx2:
+        return count_avx2(data, size, value);
+    case simd_level::sse2:
+        return count_kernel<16>(data, size, value);
+    default:
+        break;
+    }
+#endif
+    return count_scalar(data, size, value);
+}
+template<typename T>
+sum_type<T> sum(const T* data, size_t size) noexcept {
+#if UNROLLED_LIST_X86_SIMD
+    switch (level_storage().load(std::memory_order_relaxed)) {
+    case simd_level::avx2:
+        return sum_avx2(data, size);
+    case simd_level::sse2:
+        return sum_kernel<16>(data, size);
+    default:
+        break;
+    }
+#endif
+    return sum_scalar(data, size);
+}
+template<bool Max, typename T>
+T extremum(const T* data, size_t size, bool& unordered) noexcept {
+#if UNROLLED_LIST_X86_SIMD
+    switch (level_storage().load(std::memory_order_relaxed)) {
+    case simd_level::avx2:
+        return extremum_avx2<Max>(data, size, unordered);
+    case simd_level::sse2:
+        return extremum_kernel<16, Max>(data, size, unordered);
+    default:
+        break;
+    }
+#endif
+    T result = data[0];
+    for (size_t i = 0; i < size; ++i) {
+        if constexpr (std::is_floating_point_v<T>) {
+            unordered = unordered || data[i] != data[i];
+        }
+        result = Max ? std::max(result, data[i]) : std::min(result, data[i]);
+    }
+    return result;
+}
+
+}
+
+inline simd_level active_simd_level() noexcept {
+    return simd_kernels::level_storage().load(std::memory_order_relaxed);
+}
+// Возвращает уровень, который в итоге установлен
+inline simd_level set_simd_level(simd_level level) noexcept {
+    level = std::min(level, simd_kernels::detect_level());
+    simd_kernels::level_storage().store(level, std::memory_order_relaxed);
+    return level;
+}
+
+// Алгоритмы поверх segments(): цикл по каждому непрерывному куску не проверяет границы нод
+// на каждом элементе и векторизуется компилятором. Находятся через ADL, как erase_if
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+Function for_each(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Function function) {
+    for (std::span<T> segment : list.segments()) {
+        for (T& element : segment) {
+            function(element);
+        }
+    }
+    return function;
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Function>
+Function for_each(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Function function) {
+    for (std::span<const T> segment : list.segments()) {
+        for (const T& element : segment) {
+            function(element);
+        }
+    }
+    return function;
+}
+// Общая часть константной и неконстантной версий find. Для арифметических T поиск значения того же типа
+// идёт векторными ядрами simd_kernels
+template<typename List, typename U>
+auto find_in_segments(List& list, const U& value) {
+    using T = typename List::value_type;
+    auto segments = list.segments();
+    for (auto segment = segments.begin(); segment != segments.end(); ++segment) {
+        auto elements = *segment;
+        size_t offset;
+        if constexpr (simd_kernels::supported<T> && std::is_same_v<T, U>) {
+            offset = simd_kernels::find<T>(elements.data(), elements.size(), value);
+        } else {
+            offset = std::find(elements.begin(), elements.end(), value) - elements.begin();
+        }
+        if (offset != elements.size()) {
+            return segment.position(offset);
+        }
+    }
+    return list.end();
+}
+// Первый наименьший (Max == false) или первый наибольший элемент, как у std::min_element и std::max_element.
+// Векторно считается само значение, затем ищется его первое вхождение
+template<bool Max, typename List>
+auto extremum_in_segments(List& list) {
+    using T = typename List::value_type;
+    if (list.empty()) {
+        return list.end();
+    }
+    if constexpr (simd_kernels::supported<T>) {
+        bool unordered = false;
+        T best = list.front();
+        for (auto elements : list.segments()) {
+            T value = simd_kernels::extremum<Max>(elements.data(), elements.size(), unordered);
+            best = Max ? std::max(best, value) : std::min(best, value);
+        }
+        if (!unordered) {
+            return find_in_segments(list, best);
+        }
+    }
+    auto result = list.begin();
+    auto segments = list.segments();
+    for (auto segment = segments.begin(); segment != segments.end(); ++segment) {
+        auto elements = *segment;
+        auto candidate = Max ? std::max_element(elements.begin(), elements.end()) :
+            std::min_element(elements.begin(), elements.end());
+        if (Max ? *result < *candidate : *candidate < *result) {
+            result = segment.position(candidate - elements.begin());
+        }
+    }
+    return result;
+}
+
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename U>
+auto find(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, const U& value) {
+    return find_in_segments(list, value);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename U>
+auto find(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, const U& value) {
+    return find_in_segments(list, value);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename U>
+bool contains(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, const U& value) {
+    return find_in_segments(list, value) != list.end();
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename U>
+size_t count(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, const U& value) {
+    size_t result = 0;
+    for (std::span<const T> segment : list.segments()) {
+        if constexpr (simd_kernels::supported<T> && std::is_same_v<T, U>) {
+            result += simd_kernels::count<T>(segment.data(), segment.size(), value);
+        } else {
+            result += std::count(segment.begin(), segment.end(), value);
+        }
+    }
+    return result;
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+auto min_element(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list) {
+    return extremum_in_segments<false>(list);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+auto min_element(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list) {
+    return extremum_in_segments<false>(list);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+auto max_element(unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list) {
+    return extremum_in_segments<true>(list);
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+auto max_element(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list) {
+    return extremum_in_segments<true>(list);
+}
+// Сумма элементов. Целые складываются в long long (unsigned long long для беззнаковых) по модулю 2^64,
+// числа с плавающей точкой - в T, причём векторные ядра складывают в другом порядке, чем
+// последовательный цикл, и результат может отличаться в последних разрядах
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode>
+auto sum(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list) {
+    if constexpr (!simd_kernels::supported<T>) {
+        return accumulate(list, T());
+    } else if constexpr (std::is_floating_point_v<T>) {
+        T result = T();
+        for (std::span<const T> segment : list.segments()) {
+            result += simd_kernels::sum<T>(segment.data(), segment.size());
+        }
+        return result;
+    } else {
+        unsigned long long result = 0;
+        for (std::span<const T> segment : list.segments()) {
+            result += static_cast<unsigned long long>(simd_kernels::sum<T>(segment.data(), segment.size()));
+        }
+        return static_cast<simd_kernels::sum_type<T>>(result);
+    }
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode, typename Value,
+    typename BinaryOperation = std::plus<>>
+Value accumulate(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list, Value init,
+        BinaryOperation operation = BinaryOperation()) {
+    for (std::span<const T> segment : list.segments()) {
+        init = std::accumulate(segment.begin(), segment.end(), std::move(init), operation);
+    }
+    return init;
+}
+template<typename T, size_t NodeMaxSize, typename Allocator, size_t NodeMinSize, bool InlineNode,
+    typename OutputIterator>
+OutputIterator copy(const unrolled_list<T, NodeMaxSize, Allocator, NodeMinSize, InlineNode>& list,
+        OutputIterator out) {
+    for (std::span<const T> segment : list.segments()) {
+        out = std::copy(segment.begin(), segment.end(), out);
+    }
+    return out;
+}
+
+namespace pmr {
+
+// Список, берущий память из std::pmr::memory_resource. Элементы, поддерживающие аллокаторы
+// (например, std::pmr::string), конструируются с тем же ресурсом
+template<typename T, size_t NodeMaxSize = node_capacity_for_budget<T>, size_t NodeMinSize = NodeMaxSize / 2,
+    bool InlineNode = false>
+using unrolled_list = ::unrolled_list<T, NodeMaxSize, std::pmr::polymorphic_allocator<T>, NodeMinSize, InlineNode>;
+
+}
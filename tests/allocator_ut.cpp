@@ -1,8 +1,11 @@
-#include <include/unrolled_list.h>
+#include <unrolled_list.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <memory_resource>
+#include <string>
+
 class NodeTag {};
 
 class SomeObj {
@@ -54,7 +57,7 @@ public:
             ++TestAllocator<NodeTag>::AllocationCount;
             TestAllocator<NodeTag>::ElementsAllocated += sz;
         }
-        return reinterpret_cast<pointer>(new char[sz * sizeof(value_type)]);
+        return static_cast<pointer>(::operator new(sz * sizeof(value_type), std::align_val_t(alignof(value_type))));
     }
 
     void deallocate(pointer p, std::size_t n) {
@@ -109,3 +112,288 @@ TEST_F(WorkWithAllocatorTest, simplePushBack) {
     ASSERT_EQ(SomeObj::ConstructorCalled, 11);
     ASSERT_EQ(SomeObj::DestructorCalled, 11);
 }
+
+/*
+    Перемещение списка забирает ноды целиком.
+
+    Ожидается, что:
+        1. Ни перемещающий конструктор, ни перемещающее присваивание не выделяют ноды
+        2. Не создаются новые объекты SomeObj
+        3. Исходный список остаётся пустым
+*/
+
+TEST_F(WorkWithAllocatorTest, moveStealsNodes) {
+    TestAllocator<SomeObj> allocator;
+    using unrolled_list_type = unrolled_list<SomeObj, 5, TestAllocator<SomeObj>>;
+    static_assert(std::is_nothrow_move_constructible_v<unrolled_list_type>);
+    static_assert(std::is_nothrow_move_assignable_v<unrolled_list_type>);
+
+    unrolled_list_type list(allocator);
+    for (int i = 0; i < 11; ++i) {
+        list.emplace_back();
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 3);
+
+    unrolled_list_type moved(std::move(list));
+    unrolled_list_type assigned(allocator);
+    assigned = std::move(moved);
+
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 3);
+    ASSERT_EQ(SomeObj::ConstructorCalled, 11);
+    ASSERT_EQ(SomeObj::DestructorCalled, 0);
+    ASSERT_TRUE(list.empty());
+    ASSERT_TRUE(moved.empty());
+    ASSERT_EQ(assigned.size(), 11);
+}
+
+template<typename T>
+class ArenaIdAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::false_type;
+
+    explicit ArenaIdAllocator(int id) : id(id) {}
+
+    template<typename U>
+    ArenaIdAllocator(const ArenaIdAllocator<U>& other) : id(other.id) {}
+
+    T* allocate(size_t n) {
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const ArenaIdAllocator<U>& other) const {
+        return id == other.id;
+    }
+
+    int id;
+};
+
+/*
+    Аллокаторы списков не равны и не распространяются при перемещающем присваивании,
+    поэтому элементы должны быть перенесены поэлементно в ноды собственного аллокатора
+*/
+
+TEST(WorkWithAllocator, moveWithUnequalAllocators) {
+    using unrolled_list_type = unrolled_list<std::string, 3, ArenaIdAllocator<std::string>>;
+    unrolled_list_type first(ArenaIdAllocator<std::string>(1));
+    unrolled_list_type second(ArenaIdAllocator<std::string>(2));
+    for (int i = 0; i < 7; ++i) {
+        first.push_back(std::to_string(i));
+    }
+
+    second = std::move(first);
+    unrolled_list_type third(std::move(second), ArenaIdAllocator<std::string>(3));
+
+    ASSERT_EQ(third.node_allocator.id, 3);
+    ASSERT_THAT(third, ::testing::ElementsAre("0", "1", "2", "3", "4", "5", "6"));
+    ASSERT_TRUE(second.empty());
+}
+
+/*
+    Копирование идёт нода за нодой.
+
+    Ожидается, что:
+        1. Конструктор копирования выделит ровно столько нод, сколько их в исходном списке
+        2. Присваивание в список, у которого уже достаточно нод, не выделит ни одной новой
+*/
+
+TEST_F(WorkWithAllocatorTest, copyNodeByNode) {
+    TestAllocator<SomeObj> allocator;
+    using unrolled_list_type = unrolled_list<int, 5, TestAllocator<int>>;
+    unrolled_list_type list(allocator);
+    for (int i = 0; i < 11; ++i) {
+        list.push_back(i);
+    }
+    unrolled_list_type other(allocator);
+    for (int i = 0; i < 15; ++i) {
+        other.push_back(-i);
+    }
+    TestAllocator<NodeTag>::AllocationCount = 0;
+
+    unrolled_list_type copy(list);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 3);
+
+    other = copy;
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 3);
+
+    ASSERT_TRUE(copy == list);
+    ASSERT_TRUE(other == list);
+    ASSERT_THAT(other, ::testing::ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10));
+}
+
+/*
+    Очередь, колеблющаяся около границы ноды, берёт ноды из кэша освобождённых нод.
+
+    Ожидается, что:
+        1. После прогрева push_back/pop_front не обращаются к аллокатору
+        2. trim возвращает аллокатору весь кэш
+        3. При нулевом пороге кэша каждая освобождённая нода сразу возвращается аллокатору
+*/
+
+TEST_F(WorkWithAllocatorTest, nodeCacheRecyclesNodes) {
+    TestAllocator<SomeObj> allocator;
+    using unrolled_list_type = unrolled_list<int, 4, TestAllocator<int>>;
+    unrolled_list_type list(allocator);
+    for (int i = 0; i < 8; ++i) {
+        list.push_back(i);
+    }
+    for (int i = 0; i < 8; ++i) {
+        list.push_back(i);
+        list.pop_front();
+    }
+    TestAllocator<NodeTag>::AllocationCount = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        list.push_back(i);
+        list.pop_front();
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 0);
+    ASSERT_EQ(list.size(), 8);
+    ASSERT_EQ(list.front(), 992);
+    ASSERT_GT(list.node_cache_size, 0);
+
+    list.trim();
+    ASSERT_EQ(list.node_cache_size, 0);
+    ASSERT_EQ(list.node_cache, nullptr);
+
+    list.set_node_cache_limit(0);
+    for (int i = 0; i < 8; ++i) {
+        list.push_back(i);
+        list.pop_front();
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 2);
+    ASSERT_EQ(list.node_cache_size, 0);
+}
+
+/*
+    Список со встроенной нодой (InlineNode = true).
+
+    Ожидается, что:
+        1. Пока элементы помещаются во встроенную ноду, аллокатор не вызывается
+        2. При переполнении выделяются обычные ноды, а встроенная остаётся в цепочке
+        3. Перемещение и обмен переносят содержимое встроенных нод между списками
+*/
+
+TEST_F(WorkWithAllocatorTest, inlineNodeAvoidsAllocation) {
+    TestAllocator<SomeObj> allocator;
+    using unrolled_list_type = unrolled_list<int, 4, TestAllocator<int>, 2, true>;
+    unrolled_list_type small(allocator);
+    for (int i = 0; i < 4; ++i) {
+        small.push_back(i);
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 0);
+    ASSERT_EQ(small.head, &small.inline_node.node);
+
+    unrolled_list_type large(allocator);
+    for (int i = 0; i < 10; ++i) {
+        large.push_front(-i);
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 2);
+
+    small.swap(large);
+    ASSERT_THAT(small, ::testing::ElementsAre(-9, -8, -7, -6, -5, -4, -3, -2, -1, 0));
+    ASSERT_THAT(large, ::testing::ElementsAre(0, 1, 2, 3));
+    ASSERT_EQ(large.head, &large.inline_node.node);
+
+    unrolled_list_type moved(std::move(small));
+    ASSERT_TRUE(small.empty());
+    ASSERT_FALSE(small.inline_node.used);
+    ASSERT_THAT(moved, ::testing::ElementsAre(-9, -8, -7, -6, -5, -4, -3, -2, -1, 0));
+    for (auto node = moved.head; node; node = node->next) {
+        ASSERT_EQ(node->next ? node->next->prev : moved.tail, node);
+    }
+
+    large = std::move(moved);
+    ASSERT_EQ(large.size(), 10);
+    ASSERT_EQ(large.back(), 0);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 2);
+}
+
+/*
+    pmr::unrolled_list берёт память из memory_resource.
+
+    Ожидается, что:
+        1. Ноды выделяются из переданного ресурса, а не из глобальной кучи
+        2. Элементы std::pmr::string получают тот же ресурс (uses-allocator конструирование)
+        3. Копия с другим аллокатором переносит элементы в свой ресурс
+        4. Встроенная нода включается и у pmr-списка
+*/
+
+TEST_F(WorkWithAllocatorTest, pmrResources) {
+    std::pmr::unsynchronized_pool_resource pool;
+    pmr::unrolled_list<std::pmr::string, 4> list(&pool);
+    for (int i = 0; i < 10; ++i) {
+        list.emplace_back(40, static_cast<char>('a' + i));
+    }
+    list.insert(list.nth(3), std::pmr::string("inserted"));
+    list.push_front(std::pmr::string(30, 'z', std::pmr::new_delete_resource()));
+
+    ASSERT_EQ(list.get_allocator().resource(), &pool);
+    for (const auto& item : list) {
+        ASSERT_EQ(item.get_allocator().resource(), &pool);
+    }
+    ASSERT_EQ(list[4], "inserted");
+
+    alignas(64) unsigned char buffer[16384];
+    std::pmr::monotonic_buffer_resource monotonic(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    pmr::unrolled_list<std::pmr::string, 4> copy(list, &monotonic);
+    ASSERT_TRUE(copy == list);
+    ASSERT_EQ(copy.back().get_allocator().resource(), &monotonic);
+
+    pmr::unrolled_list<std::pmr::string, 4> moved(std::move(copy), &pool);
+    ASSERT_TRUE(moved == list);
+    ASSERT_EQ(moved.front().get_allocator().resource(), &pool);
+
+    pmr::unrolled_list<std::pmr::string, 4, 2, true> small(&pool);
+    small.emplace_back(40, 'x');
+    ASSERT_EQ(small.head, &small.inline_node.node);
+    ASSERT_EQ(small.front().get_allocator().resource(), &pool);
+}
+
+/*
+    reserve, resize и assign выделяют ноды цепочкой.
+
+    Ожидается, что:
+        1. После reserve(n) дописывание до n элементов не вызывает аллокатор
+        2. resize увеличивает и уменьшает список, assign заменяет содержимое
+        3. Конструктор (count, value) выделяет ровно столько нод, сколько нужно
+*/
+
+TEST_F(WorkWithAllocatorTest, reserveResizeAssign) {
+    TestAllocator<SomeObj> allocator;
+    using unrolled_list_type = unrolled_list<int, 5, TestAllocator<int>>;
+    unrolled_list_type list(allocator);
+    list.reserve(23);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 5);
+
+    for (int i = 0; i < 20; ++i) {
+        list.push_back(i);
+    }
+    list.resize(23, -1);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 5);
+    ASSERT_EQ(list.size(), 23);
+    ASSERT_EQ(list.back(), -1);
+
+    list.resize(3);
+    ASSERT_THAT(list, ::testing::ElementsAre(0, 1, 2));
+    list.resize(6);
+    ASSERT_THAT(list, ::testing::ElementsAre(0, 1, 2, 0, 0, 0));
+
+    list.assign(4, list.front());
+    ASSERT_THAT(list, ::testing::ElementsAre(0, 0, 0, 0));
+    list.assign({7, 8, 9});
+    ASSERT_THAT(list, ::testing::ElementsAre(7, 8, 9));
+    list = {1, 2};
+    ASSERT_THAT(list, ::testing::ElementsAre(1, 2));
+
+    TestAllocator<NodeTag>::AllocationCount = 0;
+    unrolled_list_type filled(12, 42, allocator);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, 3);
+    ASSERT_EQ(filled.size(), 12);
+    ASSERT_EQ(filled.back(), 42);
+}
@@ -0,0 +1,262 @@
+#include <directory_unrolled_list.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+static_assert(std::random_access_iterator<directory_unrolled_list<int>::iterator>);
+static_assert(std::random_access_iterator<directory_unrolled_list<int>::const_iterator>);
+static_assert(std::ranges::random_access_range<directory_unrolled_list<std::string>>);
+
+// Вместимость ноды по умолчанию считается от её настоящего заголовка: нода укладывается
+// в 4 кэш-линии, и добавление ещё одного элемента вывело бы её за бюджет
+static_assert(sizeof(directory_unrolled_list<int>::Node) == 4 * cache_line_size);
+static_assert(directory_node_capacity_for_budget<int> == (4 * cache_line_size - 2 * sizeof(void*)) / sizeof(int));
+static_assert(sizeof(directory_unrolled_list<std::string>::Node) <= 4 * cache_line_size);
+static_assert(sizeof(directory_unrolled_list<std::string, directory_node_capacity_for_budget<std::string> + 1>::Node) >
+    4 * cache_line_size);
+
+// Проверяет, что каталог и цепочка prev/next перечисляют одни и те же ноды и что нод ровно столько,
+// сколько нужно под элементы при заполненных внутренних нодах
+template<typename List>
+void CheckDirectory(const List& list, size_t node_max_size) {
+    if (list.empty()) {
+        EXPECT_EQ(list.node_count, 0);
+        EXPECT_EQ(list.head, nullptr);
+        EXPECT_EQ(list.tail, nullptr);
+        EXPECT_EQ(list.front_offset, 0);
+        return;
+    }
+    EXPECT_LT(list.front_offset, node_max_size);
+    EXPECT_EQ(list.node_count, (list.front_offset + list.size() + node_max_size - 1) / node_max_size);
+    EXPECT_LE(list.directory_first + list.node_count, list.directory_capacity);
+    auto node = list.head;
+    for (size_t i = 0; i < list.node_count; ++i, node = node->next) {
+        EXPECT_EQ(list.directory[list.directory_first + i], node);
+        EXPECT_EQ(node->prev, i == 0 ? nullptr : list.directory[list.directory_first + i - 1]);
+    }
+    EXPECT_EQ(node, nullptr);
+    EXPECT_EQ(list.tail, list.directory[list.directory_first + list.node_count - 1]);
+}
+
+/*
+    Случайные вставки и удаления с обоих концов и в середине сравниваются с std::deque.
+    Маленькая нода заставляет часто добавлять и снимать крайние ноды и двигать каталог
+
+    Ожидается, что:
+        1. Содержимое и доступ по индексу совпадают с std::deque
+        2. Разность итераторов и сдвиг на n согласованы с индексами
+        3. Каталог и цепочка нод остаются согласованными
+*/
+
+TEST(DirectoryUnrolledList, randomOperations) {
+    directory_unrolled_list<int, 3> list;
+    std::deque<int> expected;
+    std::mt19937 rng(23);
+
+    for (int step = 0; step < 20000; ++step) {
+        size_t action = rng() % 8;
+        size_t position = expected.empty() ? 0 : rng() % (expected.size() + 1);
+        if (action < 2) {
+            list.push_back(step);
+            expected.push_back(step);
+        } else if (action < 4) {
+            list.push_front(step);
+            expected.push_front(step);
+        } else if (action == 4) {
+            list.insert(list.nth(position), step);
+            expected.insert(expected.begin() + position, step);
+        } else if (!expected.empty()) {
+            if (action == 5) {
+                list.pop_back();
+                expected.pop_back();
+            } else if (action == 6) {
+                list.pop_front();
+                expected.pop_front();
+            } else {
+                size_t count = std::min<size_t>(rng() % 5, expected.size() - position);
+                list.erase(list.nth(position), list.nth(position + count));
+                expected.erase(expected.begin() + position, expected.begin() + position + count);
+            }
+        }
+        if (step % 1000 == 0) {
+            CheckDirectory(list, 3);
+        }
+    }
+
+    CheckDirectory(list, 3);
+    ASSERT_EQ(list.size(), expected.size());
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    ASSERT_EQ(list.end() - list.begin(), static_cast<std::ptrdiff_t>(expected.size()));
+    for (size_t i = 0; i < expected.size(); i += 7) {
+        ASSERT_EQ(list[i], expected[i]);
+        ASSERT_EQ(list.begin()[i], expected[i]);
+        ASSERT_EQ(*(list.end() - static_cast<std::ptrdiff_t>(expected.size() - i)), expected[i]);
+        ASSERT_EQ(list.index_of(list.nth(i)), i);
+    }
+
+    while (!expected.empty()) {
+        list.pop_front();
+        expected.pop_front();
+    }
+    CheckDirectory(list, 3);
+    ASSERT_TRUE(list.begin() == list.end());
+}
+
+/*
+    Алгоритмы, требующие итератора произвольного доступа, работают на списке напрямую
+*/
+
+TEST(DirectoryUnrolledList, randomAccessAlgorithms) {
+    directory_unrolled_list<int, 5> list;
+    std::vector<int> expected;
+    std::mt19937 rng(5);
+    for (int i = 0; i < 1000; ++i) {
+        int value = static_cast<int>(rng() % 300);
+        if (i % 2 == 0) {
+            list.push_front(value);
+            expected.insert(expected.begin(), value);
+        } else {
+            list.push_back(value);
+            expected.push_back(value);
+        }
+    }
+
+    auto middle = list.begin() + 500;
+    std::nth_element(list.begin(), middle, list.end());
+    std::nth_element(expected.begin(), expected.begin() + 500, expected.end());
+    ASSERT_EQ(*middle, expected[500]);
+    ASSERT_TRUE(std::all_of(list.begin(), middle, [&](int value) { return value <= *middle; }));
+
+    std::sort(list.begin(), list.end());
+    std::sort(expected.begin(), expected.end());
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    for (int value : {-1, 0, 150, 299, 300}) {
+        auto found = std::lower_bound(std::as_const(list).begin(), std::as_const(list).end(), value);
+        ASSERT_EQ(found - list.cbegin(), std::lower_bound(expected.begin(), expected.end(), value) - expected.begin());
+    }
+    std::reverse(list.begin(), list.end());
+    ASSERT_TRUE(std::equal(list.rbegin(), list.rend(), expected.begin(), expected.end()));
+    CheckDirectory(list, 5);
+}
+
+/*
+    Вставки диапазонов и повторов в случайные позиции сравниваются с std::deque
+
+    Ожидается, что:
+        1. Содержимое совпадает с std::deque, возвращается итератор на первый вставленный элемент
+        2. Вставка ближе к началу не трогает хвост, а ближе к концу — голову: сдвигается только
+           более короткая сторона
+        3. Если конструктор выбросит исключение посреди вставки, список не меняется
+*/
+
+struct ThrowingCopy {
+    static inline int copies_left = -1;
+    int value;
+    ThrowingCopy(int value) : value(value) {}
+    ThrowingCopy(const ThrowingCopy& other) : value(other.value) {
+        if (copies_left == 0) {
+            throw std::runtime_error("copy");
+        }
+        --copies_left;
+    }
+    ThrowingCopy& operator=(const ThrowingCopy&) = default;
+    bool operator==(const ThrowingCopy&) const = default;
+};
+
+TEST(DirectoryUnrolledList, rangeInsert) {
+    directory_unrolled_list<int, 4> list;
+    std::deque<int> expected;
+    std::mt19937 rng(25);
+
+    for (int step = 0; step < 3000; ++step) {
+        size_t position = rng() % (expected.size() + 1);
+        size_t count = 1 + rng() % 9;
+        auto head = list.head;
+        auto tail = list.tail;
+        std::vector<int> values(count);
+        std::iota(values.begin(), values.end(), step * 10);
+        auto inserted = step % 2 == 0
+            ? list.insert(list.nth(position), values.begin(), values.end())
+            : list.insert(list.nth(position), count, step);
+        if (step % 2 == 0) {
+            expected.insert(expected.begin() + position, values.begin(), values.end());
+        } else {
+            expected.insert(expected.begin() + position, count, step);
+        }
+        ASSERT_EQ(list.index_of(inserted), position);
+        if (position < expected.size() - count - position) {
+            ASSERT_EQ(list.tail, tail);
+        } else if (head != nullptr) {
+            ASSERT_EQ(list.head, head);
+        }
+        if (expected.size() > 200) {
+            size_t erased = rng() % expected.size();
+            list.erase(list.nth(erased), list.end());
+            expected.erase(expected.begin() + erased, expected.end());
+        }
+    }
+    CheckDirectory(list, 4);
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+
+    directory_unrolled_list<ThrowingCopy, 4> throwing;
+    for (int i = 0; i < 30; ++i) {
+        throwing.push_back(i);
+    }
+    std::vector<ThrowingCopy> before(throwing.begin(), throwing.end());
+    std::vector<ThrowingCopy> values(10, ThrowingCopy(-1));
+    for (size_t position : {2, 15, 28}) {
+        ThrowingCopy::copies_left = 6;
+        ASSERT_THROW(throwing.insert(throwing.nth(position), values.begin(), values.end()), std::runtime_error);
+        ThrowingCopy::copies_left = 6;
+        ASSERT_THROW(throwing.insert(throwing.nth(position), 10, values.front()), std::runtime_error);
+        ThrowingCopy::copies_left = -1;
+        ASSERT_TRUE(std::equal(throwing.begin(), throwing.end(), before.begin(), before.end()));
+        CheckDirectory(throwing, 4);
+    }
+}
+
+TEST(DirectoryUnrolledList, stlInterface) {
+    directory_unrolled_list<std::string, 4> list = {"b", "c"};
+    list.push_front("a");
+    list.emplace_back(3, 'd');
+    list.insert(list.nth(1), 2, list.front());
+    list.erase(list.nth(3), list.end());
+
+    std::vector<std::string> expected = {"a", "a", "a"};
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    ASSERT_EQ(*std::prev(list.end()), "a");
+    ASSERT_THROW(list.at(3), std::out_of_range);
+
+    auto copy = list;
+    ASSERT_EQ(copy, list);
+    auto moved = std::move(copy);
+    ASSERT_TRUE(copy.empty());
+    ASSERT_EQ(moved, list);
+
+    for (int i = 0; i < 100; ++i) {
+        moved.push_back(std::to_string(i));
+    }
+    moved.erase(moved.begin(), moved.nth(3));
+    moved.insert(moved.nth(50), {"x", "y"});
+    moved.erase(moved.nth(10), moved.nth(10));
+    ASSERT_EQ(moved[10], "10");
+    ASSERT_EQ(moved.front(), "0");
+    ASSERT_EQ(moved.back(), "99");
+    ASSERT_EQ(moved[50], "x");
+    ASSERT_EQ(moved[52], "50");
+    ASSERT_EQ(*moved.rbegin(), "99");
+    CheckDirectory(moved, 4);
+
+    moved.clear();
+    moved.push_front("z");
+    ASSERT_EQ(moved.size(), 1);
+    ASSERT_EQ(moved.back(), "z");
+    CheckDirectory(moved, 4);
+}
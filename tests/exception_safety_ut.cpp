@@ -1,9 +1,13 @@
-#include <include/unrolled_list.h>
+#include <tiered_unrolled_list.h>
+#include <unrolled_list.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <list>
+#include <random>
+#include <vector>
 
 class NodeTag {};
 
@@ -74,7 +78,7 @@ public:
             ++TestAllocator<NodeTag>::DeallocationCount;
             TestAllocator<NodeTag>::ElementsDeallocated += n;
         }
-        delete[] reinterpret_cast<char*>(p);
+        ::operator delete(p, std::align_val_t(alignof(value_type)));
     }
 
     pointer allocate(size_type sz) {
@@ -85,7 +89,7 @@ public:
             ++TestAllocator<NodeTag>::AllocationCount;
             TestAllocator<NodeTag>::ElementsAllocated += sz;
         }
-        return reinterpret_cast<pointer>(new char[sz * sizeof(value_type)]);
+        return static_cast<pointer>(::operator new(sz * sizeof(value_type), std::align_val_t(alignof(value_type))));
     }
 
 };
@@ -190,3 +194,257 @@ TEST_F(ExceptionSafetyTest, failesAtPushBack) {
     ASSERT_EQ(unrolled_list.begin()->Name, std::string("first"));
     ASSERT_EQ((++unrolled_list.begin())->Name, std::string("second"));
 }
+
+/*
+    emplace в середину полной ноды, конструктор элемента выбрасывает исключение.
+
+    Тест проверяет:
+        1. emplace от Bad выбросит исключение
+        2. Содержимое списка не изменится
+*/
+
+TEST_F(ExceptionSafetyTest, failesAtEmplace) {
+    unrolled_list<BadOrGood, 4> unrolled_list;
+    for (int i = 0; i < 4; ++i) {
+        unrolled_list.emplace_back(Good{.Name = std::to_string(i)});
+    }
+
+    ASSERT_ANY_THROW(unrolled_list.emplace(++unrolled_list.begin(), Bad{}));
+    ASSERT_ANY_THROW(unrolled_list.emplace_front(Bad{}));
+    ASSERT_ANY_THROW(unrolled_list.emplace_back(Bad{}));
+
+    ASSERT_EQ(unrolled_list.size(), 4);
+    int expected = 0;
+    for (const auto& item : unrolled_list) {
+        ASSERT_EQ(item.Name, std::to_string(expected++));
+    }
+}
+
+/*
+    Конструктор копирования SomeObj выбрасывает исключение на третьем вызове.
+
+    Тест проверяет:
+        1. Конструктор копирования списка выбросит исключение
+        2. Для двух успешно скопированных объектов будет вызван деструктор
+        3. Все выделенные ноды будут освобождены
+*/
+
+TEST_F(ExceptionSafetyTest, failesAtCopy) {
+    using unrolled_list_type = unrolled_list<SomeObj, 2, TestAllocator<SomeObj>>;
+    unrolled_list_type source;
+    for (int i = 0; i < 5; ++i) {
+        source.emplace_back();
+    }
+    SomeObj::DestructorCalled = 0;
+    TestAllocator<NodeTag>::AllocationCount = 0;
+
+    ASSERT_ANY_THROW(unrolled_list_type copy(source));
+
+    ASSERT_EQ(SomeObj::DestructorCalled, 2);
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, TestAllocator<NodeTag>::DeallocationCount);
+}
+
+/*
+    Вставка диапазона, в котором конструктор одного из элементов выбрасывает исключение.
+    Диапазон длиннее ноды, поэтому новые элементы собираются в отдельной цепочке нод.
+
+    Тест проверяет:
+        1. append_range и insert выбросят исключение
+        2. Содержимое списка не изменится
+        3. Все выделенные ноды будут освобождены
+*/
+
+TEST_F(ExceptionSafetyTest, failesAtRangeInsert) {
+    using unrolled_list_type = unrolled_list<SomeObj, 2, TestAllocator<SomeObj>>;
+    {
+        unrolled_list_type unrolled_list;
+        for (int i = 0; i < 3; ++i) {
+            unrolled_list.emplace_back();
+        }
+        std::list<SomeObj> source(5);
+        SomeObj::CopiesCount = 0;
+
+        ASSERT_ANY_THROW(unrolled_list.append_range(source));
+        SomeObj::CopiesCount = 0;
+        ASSERT_ANY_THROW(unrolled_list.insert(++unrolled_list.begin(), source.begin(), source.end()));
+
+        ASSERT_EQ(unrolled_list.size(), 3);
+        ASSERT_EQ(std::distance(unrolled_list.begin(), unrolled_list.end()), 3);
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, TestAllocator<NodeTag>::DeallocationCount);
+}
+
+/*
+    Компаратор выбрасывает исключение посреди сортировки.
+    sort даёт базовую гарантию: все элементы остаются в списке, ноды не теряются и не утекают
+*/
+
+TEST_F(ExceptionSafetyTest, failesAtSort) {
+    using unrolled_list_type = unrolled_list<int, 3, TestAllocator<int>>;
+    {
+        unrolled_list_type unrolled_list;
+        std::vector<int> expected;
+        for (int i = 0; i < 100; ++i) {
+            unrolled_list.push_back((i * 31) % 17);
+            expected.push_back((i * 31) % 17);
+        }
+        std::sort(expected.begin(), expected.end());
+        int comparisons = 0;
+        auto comp = [&comparisons](int lhs, int rhs) {
+            if (++comparisons == 400) {
+                throw std::runtime_error("");
+            }
+            return lhs < rhs;
+        };
+
+        ASSERT_ANY_THROW(unrolled_list.sort(comp));
+
+        ASSERT_EQ(unrolled_list.size(), 100);
+        ASSERT_EQ(std::distance(unrolled_list.begin(), unrolled_list.end()), 100);
+        std::vector<int> values(unrolled_list.begin(), unrolled_list.end());
+        std::sort(values.begin(), values.end());
+        ASSERT_TRUE(std::equal(values.begin(), values.end(), expected.begin(), expected.end()));
+        unrolled_list.sort();
+        ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), expected.begin(), expected.end()));
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, TestAllocator<NodeTag>::DeallocationCount);
+}
+
+class CopyOnly {
+public:
+    static inline int CopiesLeft = -1;
+
+    CopyOnly(int value)
+        : Value(value) {}
+
+    CopyOnly(const CopyOnly& other)
+        : Value(other.Value) {
+        if (CopiesLeft >= 0 && CopiesLeft-- == 0) {
+            throw std::runtime_error("");
+        }
+    }
+
+    CopyOnly& operator=(const CopyOnly&) = default;
+
+    int Value;
+};
+
+/*
+    Тип без перемещения, копирование которого может выбросить исключение. Такие элементы нельзя
+    сдвигать внутри ноды, поэтому вставка и удаление в середине ноды копируют хвост ноды в новую.
+
+    Тест проверяет:
+        1. Исключение при копировании вылетает из insert, emplace и erase, а не завершает программу
+        2. После исключения содержимое списка не меняется
+        3. Без исключений вставка, удаление и sort работают как обычно
+*/
+
+TEST_F(ExceptionSafetyTest, failesAtInNodeShift) {
+    static_assert(!unrolled_list<CopyOnly, 8>::nothrow_relocatable);
+    unrolled_list<CopyOnly, 8> unrolled_list;
+    std::vector<int> expected;
+    for (int i = 0; i < 6; ++i) {
+        unrolled_list.push_back(i);
+        expected.push_back(i);
+    }
+    auto check = [&] {
+        ASSERT_EQ(unrolled_list.size(), expected.size());
+        ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), expected.begin(), expected.end(),
+            [](const CopyOnly& item, int value) { return item.Value == value; }));
+    };
+
+    CopyOnly value(10);
+    CopyOnly::CopiesLeft = 2;
+    ASSERT_ANY_THROW(unrolled_list.insert(std::next(unrolled_list.begin(), 2), value));
+    check();
+    CopyOnly::CopiesLeft = 1;
+    ASSERT_ANY_THROW(unrolled_list.emplace(std::next(unrolled_list.begin(), 3), value));
+    check();
+    CopyOnly::CopiesLeft = 1;
+    ASSERT_ANY_THROW(unrolled_list.erase(std::next(unrolled_list.begin(), 1)));
+    check();
+    CopyOnly::CopiesLeft = 0;
+    ASSERT_ANY_THROW(unrolled_list.erase(std::next(unrolled_list.begin(), 1), std::next(unrolled_list.begin(), 3)));
+    check();
+
+    CopyOnly::CopiesLeft = -1;
+    unrolled_list.insert(std::next(unrolled_list.begin(), 2), value);
+    expected.insert(expected.begin() + 2, 10);
+    unrolled_list.erase(std::next(unrolled_list.begin(), 4));
+    expected.erase(expected.begin() + 4);
+    unrolled_list.erase(std::next(unrolled_list.begin(), 1), std::next(unrolled_list.begin(), 3));
+    expected.erase(expected.begin() + 1, expected.begin() + 3);
+    check();
+    for (int i = 0; i < 20; ++i) {
+        unrolled_list.push_front((i * 7) % 13);
+        expected.insert(expected.begin(), (i * 7) % 13);
+    }
+    check();
+    unrolled_list.sort([](const CopyOnly& lhs, const CopyOnly& rhs) { return lhs.Value < rhs.Value; });
+    std::stable_sort(expected.begin(), expected.end());
+    check();
+}
+
+/*
+    То же для tiered_unrolled_list: элементы CopyOnly не сдвигаются внутри листа, поэтому вставка
+    и удаление не с конца листа копируют хвост листа в новый лист.
+
+    Тест проверяет:
+        1. Исключение при копировании вылетает из insert, emplace, erase и pop_front, а не завершает программу
+        2. После исключения содержимое списка не меняется, а все выделенные листья освобождены
+        3. Без исключений вставки и удаления в случайные позиции работают как обычно
+*/
+
+TEST_F(ExceptionSafetyTest, tieredFailesAtInLeafShift) {
+    static_assert(!tiered_unrolled_list<CopyOnly, 8>::nothrow_relocatable);
+    {
+        tiered_unrolled_list<CopyOnly, 8, TestAllocator<CopyOnly>, 4> list;
+        std::vector<int> expected;
+        for (int i = 0; i < 6; ++i) {
+            list.push_back(i);
+            expected.push_back(i);
+        }
+        auto check = [&] {
+            ASSERT_EQ(list.size(), expected.size());
+            ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end(),
+                [](const CopyOnly& item, int value) { return item.Value == value; }));
+        };
+
+        CopyOnly value(10);
+        CopyOnly::CopiesLeft = 2;
+        ASSERT_ANY_THROW(list.insert(list.nth(2), value));
+        check();
+        CopyOnly::CopiesLeft = 1;
+        ASSERT_ANY_THROW(list.emplace(list.nth(3), value));
+        check();
+        CopyOnly::CopiesLeft = 1;
+        ASSERT_ANY_THROW(list.erase(list.nth(1)));
+        check();
+        CopyOnly::CopiesLeft = 0;
+        ASSERT_ANY_THROW(list.pop_front());
+        check();
+        CopyOnly::CopiesLeft = 0;
+        ASSERT_ANY_THROW(list.erase(list.nth(1), list.nth(3)));
+        check();
+        CopyOnly::CopiesLeft = 0;
+        list.pop_back();
+        expected.pop_back();
+        check();
+
+        CopyOnly::CopiesLeft = -1;
+        std::mt19937 rng(8);
+        for (int step = 0; step < 2000; ++step) {
+            size_t position = rng() % (expected.size() + 1);
+            if (rng() % 3 < 2 || expected.empty()) {
+                list.insert(list.nth(position), step);
+                expected.insert(expected.begin() + position, step);
+            } else {
+                position %= expected.size();
+                list.erase(list.nth(position));
+                expected.erase(expected.begin() + position);
+            }
+        }
+        check();
+    }
+    ASSERT_EQ(TestAllocator<NodeTag>::AllocationCount, TestAllocator<NodeTag>::DeallocationCount);
+}
@@ -1,4 +1,4 @@
-#include <include/unrolled_list.h>
+#include <unrolled_list.h>
 #include <gtest/gtest.h>
 #include <iterator>
 
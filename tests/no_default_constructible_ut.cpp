@@ -1,4 +1,4 @@
-#include <include/unrolled_list.h>
+#include <unrolled_list.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -19,3 +19,22 @@ TEST(NoDefaultConstructible, canConstruct) {
 
     ASSERT_EQ(unrolled_list.size(), 2);
 }
+
+/*
+    Тест проверяет, что вставка в середину (с разбиением полной ноды) и удаление
+    не требуют от хранимого типа конструктора по-умолчанию
+*/
+TEST(NoDefaultConstructible, insertAndErase) {
+    unrolled_list<NoDefaultConstructible, 4> unrolled_list;
+    for (int i = 0; i < 10; ++i) {
+        unrolled_list.push_back(NoDefaultConstructible(i));
+    }
+
+    auto it = unrolled_list.begin();
+    ++it;
+    unrolled_list.insert(it, NoDefaultConstructible(42));
+    unrolled_list.insert(unrolled_list.begin(), 6, NoDefaultConstructible(7));
+    unrolled_list.erase(unrolled_list.begin());
+
+    ASSERT_EQ(unrolled_list.size(), 16);
+}
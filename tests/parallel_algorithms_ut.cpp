@@ -0,0 +1,102 @@
+#include <parallel_algorithms.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+/*
+    Параллельные алгоритмы на пулах разного размера сравниваются с последовательными.
+    Список собирается с обоих концов, поэтому в нём есть ноды с перекинутым кольцевым буфером,
+    а размер не кратен ни размеру ноды, ни числу прогонов
+*/
+TEST(ParallelAlgorithms, matchSequential) {
+    unrolled_list<long long> list;
+    for (long long i = 0; i < 200003; ++i) {
+        if (i % 3 == 0) {
+            list.push_front(i);
+        } else {
+            list.push_back(i);
+        }
+    }
+    std::vector<long long> vector(list.begin(), list.end());
+    long long expected_sum = std::accumulate(vector.begin(), vector.end(), 0LL);
+    size_t expected_odd = std::count_if(vector.begin(), vector.end(), [](long long value) { return value % 2 != 0; });
+    for (size_t threads : {1, 2, 5}) {
+        thread_pool pool(threads);
+        ASSERT_EQ(pool.concurrency(), threads);
+        ASSERT_EQ(parallel_reduce(pool, list, 0LL), expected_sum);
+        ASSERT_EQ(parallel_count_if(pool, list, [](long long value) { return value % 2 != 0; }), expected_odd);
+
+        std::atomic<size_t> visited = 0;
+        parallel_for_each(pool, std::as_const(list), [&visited](const long long&) { ++visited; });
+        ASSERT_EQ(visited, list.size());
+
+        parallel_transform(pool, list, [](long long value) { return value * 3; });
+        parallel_for_each(pool, list, [](long long& value) { value /= 3; });
+        ASSERT_TRUE(std::equal(list.begin(), list.end(), vector.begin(), vector.end()));
+        ASSERT_EQ(parallel_reduce(pool, list, 0LL), expected_sum);
+    }
+    ASSERT_EQ(parallel_reduce(list, 10LL, [](long long lhs, long long rhs) { return std::max(lhs, rhs); }), 200002);
+
+    unrolled_list<long long> empty;
+    ASSERT_EQ(parallel_reduce(empty, 7LL), 7);
+    ASSERT_EQ(parallel_count_if(empty, [](long long) { return true; }), 0);
+}
+
+/*
+    Исключение из функтора пробрасывается вызывающему, а пул остаётся рабочим
+*/
+TEST(ParallelAlgorithms, exceptionPropagates) {
+    thread_pool pool(4);
+    unrolled_list<int> list;
+    for (int i = 0; i < 100000; ++i) {
+        list.push_back(i);
+    }
+    ASSERT_THROW(parallel_for_each(pool, list, [](int& value) {
+        if (value == 77777) {
+            throw std::runtime_error("");
+        }
+    }), std::runtime_error);
+    ASSERT_EQ(parallel_count_if(pool, list, [](int value) { return value < 1000; }), 1000);
+}
+
+/*
+    Границы прогонов константного списка без построенного индекса ищутся проходом по цепочке нод,
+    индекс не строится. Поэтому один и тот же список можно одновременно обходить из нескольких потоков
+
+    Ожидается, что:
+        1. Одновременные parallel_reduce и parallel_count_if из разных потоков дают верный результат
+        2. Индекс позиций списка остаётся непостроенным
+        3. С построенным индексом результат тот же
+*/
+TEST(ParallelAlgorithms, concurrentConstPasses) {
+    unrolled_list<int> list;
+    for (int i = 0; i < 300000; ++i) {
+        list.push_back(i % 1000);
+    }
+    ASSERT_FALSE(list.index_valid);
+    const auto& const_list = list;
+    long long expected_sum = 300LL * 999 * 1000 / 2;
+
+    thread_pool pool(3);
+    std::atomic<int> mismatches = 0;
+    std::thread other([&] {
+        for (int i = 0; i < 20; ++i) {
+            mismatches += parallel_reduce(const_list, 0LL) != expected_sum;
+        }
+    });
+    for (int i = 0; i < 20; ++i) {
+        mismatches += parallel_count_if(pool, const_list, [](int value) { return value < 10; }) != 3000;
+    }
+    other.join();
+    ASSERT_EQ(mismatches, 0);
+    ASSERT_FALSE(list.index_valid);
+
+    ASSERT_EQ(list[12345], 345);
+    ASSERT_TRUE(list.index_valid);
+    ASSERT_EQ(parallel_reduce(pool, const_list, 0LL), expected_sum);
+}
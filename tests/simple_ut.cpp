@@ -1,11 +1,38 @@
-#include <include/unrolled_list.h>
+#include <unrolled_list.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <sstream>
+#include <string>
 #include <vector>
 #include <list>
 
+struct RelocatableHandle {
+    static inline int DestructorCalled = 0;
+
+    explicit RelocatableHandle(int value) : value(new int(value)) {}
+
+    RelocatableHandle(const RelocatableHandle& other) : value(new int(*other.value)) {}
+
+    RelocatableHandle(RelocatableHandle&& other) noexcept : value(other.value) {
+        other.value = nullptr;
+    }
+
+    ~RelocatableHandle() {
+        ++DestructorCalled;
+        delete value;
+    }
+
+    int* value;
+};
+
+template<>
+struct is_trivially_relocatable<RelocatableHandle> : std::true_type {};
+
 /*
     Ниже представлен ряд тестов, где используются (вместе, раздельно и по-очереди):
         - empty
@@ -211,3 +238,790 @@ TEST(UnrolledLinkedList, popFrontBack) {
 
     ASSERT_TRUE(unrolled_list.empty());
 }
+
+/*
+    Шаг назад из end() попадает на последний элемент, поэтому обратный обход работает
+    и для изменяемого, и для константного списка
+*/
+
+TEST(UnrolledLinkedList, reverseIteration) {
+    std::list<int> std_list;
+    unrolled_list<int, 4> unrolled_list;
+    for (int i = 0; i < 10; ++i) {
+        std_list.push_back(i);
+        unrolled_list.push_back(i);
+    }
+
+    ASSERT_EQ(*--unrolled_list.end(), 9);
+    ASSERT_EQ(*unrolled_list.rbegin(), 9);
+    ASSERT_EQ(*std::prev(std::as_const(unrolled_list).end(), 3), 7);
+    ASSERT_TRUE(std::equal(unrolled_list.rbegin(), unrolled_list.rend(), std_list.rbegin(), std_list.rend()));
+    ASSERT_TRUE(std::equal(unrolled_list.crbegin(), unrolled_list.crend(), std_list.rbegin(), std_list.rend()));
+
+    auto last = unrolled_list.end();
+    --last;
+    unrolled_list.erase(last);
+    ASSERT_EQ(unrolled_list.back(), 8);
+    ASSERT_EQ(*unrolled_list.rbegin(), 8);
+}
+
+/*
+    Ноды хранят элементы кольцевым буфером со смещением начала.
+    Ниже список используется как двусторонняя очередь с маленьким NodeMaxSize,
+    а затем в ноды, у которых элементы "перевалили" через конец буфера, вставляются
+    и из них удаляются элементы. Ожидается, что порядок совпадёт с std::list
+*/
+
+TEST(UnrolledLinkedList, dequeWorkload) {
+    std::list<int> std_list;
+    unrolled_list<int, 4> unrolled_list;
+
+    for (int i = 0; i < 1000; ++i) {
+        if (i % 3 == 2) {
+            std_list.pop_back();
+            unrolled_list.pop_back();
+        } else {
+            std_list.push_front(i);
+            unrolled_list.push_front(i);
+        }
+        if (i % 7 == 0) {
+            std_list.push_back(-i);
+            unrolled_list.push_back(-i);
+        }
+    }
+
+    ASSERT_THAT(unrolled_list, ::testing::ElementsAreArray(std_list));
+    ASSERT_EQ(unrolled_list.front(), std_list.front());
+    ASSERT_EQ(unrolled_list.back(), std_list.back());
+}
+
+TEST(UnrolledLinkedList, insertEraseInWrappedNodes) {
+    std::list<int> std_list;
+    unrolled_list<int, 5> unrolled_list;
+
+    for (int i = 0; i < 200; ++i) {
+        std_list.push_front(i);
+        unrolled_list.push_front(i);
+        std_list.push_back(i);
+        unrolled_list.push_back(i);
+    }
+
+    for (int i = 0; i < 300; ++i) {
+        auto std_it = std_list.begin();
+        auto unrolled_it = unrolled_list.begin();
+        size_t offset = (i * 37) % std_list.size();
+        std::advance(std_it, offset);
+        std::advance(unrolled_it, offset);
+        if (i % 2 == 0) {
+            std_list.insert(std_it, i % 4 + 1, i);
+            unrolled_list.insert(unrolled_it, i % 4 + 1, i);
+        } else {
+            std_list.erase(std_it);
+            unrolled_list.erase(unrolled_it);
+        }
+    }
+
+    ASSERT_THAT(unrolled_list, ::testing::ElementsAreArray(std_list));
+}
+
+/*
+    Тип RelocatableHandle помечен как trivially relocatable, поэтому сдвиги внутри нод
+    и разбиение нод переносят его побайтово, без вызова конструктора перемещения и деструктора.
+    Ожидается, что деструктор будет вызван только для удалённых элементов
+*/
+
+TEST(UnrolledLinkedList, triviallyRelocatableShifts) {
+    unrolled_list<RelocatableHandle, 8> unrolled_list;
+    for (int i = 0; i < 40; ++i) {
+        unrolled_list.push_back(RelocatableHandle(i));
+    }
+    auto it = unrolled_list.begin();
+    std::advance(it, 3);
+    unrolled_list.insert(it, 5, RelocatableHandle(-1));
+    it = unrolled_list.begin();
+    std::advance(it, 12);
+    unrolled_list.erase(it);
+    unrolled_list.pop_front();
+
+    RelocatableHandle::DestructorCalled = 0;
+    it = unrolled_list.begin();
+    std::advance(it, 20);
+    unrolled_list.erase(it, std::next(it, 6));
+    unrolled_list.erase(std::next(unrolled_list.begin(), 2));
+
+    ASSERT_EQ(RelocatableHandle::DestructorCalled, 7);
+    ASSERT_EQ(unrolled_list.size(), 36);
+
+    std::vector<int> expected = {1, 2, -1, -1, -1, -1, 3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    for (int i = 23; i < 40; ++i) {
+        expected.push_back(i);
+    }
+    std::vector<int> actual;
+    for (const auto& handle : unrolled_list) {
+        actual.push_back(*handle.value);
+    }
+    ASSERT_THAT(actual, ::testing::ElementsAreArray(expected));
+}
+
+struct CopyCounter {
+    static inline int CopiesCount = 0;
+
+    CopyCounter(int a, int b) : value(a + b) {}
+
+    CopyCounter(const CopyCounter& other) : value(other.value) {
+        ++CopiesCount;
+    }
+
+    CopyCounter(CopyCounter&& other) noexcept : value(other.value) {}
+
+    int value;
+};
+
+/*
+    Тест проверяет, что emplace_back, emplace_front, emplace и rvalue-перегрузки
+    push_back, push_front и insert не копируют элементы, в том числе при разбиении полных нод
+*/
+
+TEST(UnrolledLinkedList, emplaceDoesNotCopy) {
+    CopyCounter::CopiesCount = 0;
+    unrolled_list<CopyCounter, 4> unrolled_list;
+
+    for (int i = 0; i < 10; ++i) {
+        unrolled_list.emplace_back(i, 0);
+        unrolled_list.emplace_front(-i, 0);
+    }
+    unrolled_list.push_back(CopyCounter(100, 0));
+    unrolled_list.push_front(CopyCounter(-100, 0));
+    auto it = unrolled_list.emplace(std::next(unrolled_list.begin(), 5), 20, 30);
+    ASSERT_EQ(it->value, 50);
+    it = unrolled_list.insert(std::next(unrolled_list.begin(), 13), CopyCounter(7, 7));
+    ASSERT_EQ(it->value, 14);
+
+    ASSERT_EQ(CopyCounter::CopiesCount, 0);
+    ASSERT_EQ(unrolled_list.size(), 24);
+    ASSERT_EQ(unrolled_list.front().value, -100);
+    ASSERT_EQ(unrolled_list.back().value, 100);
+    ASSERT_EQ(std::next(unrolled_list.begin(), 5)->value, 50);
+    ASSERT_EQ(std::next(unrolled_list.begin(), 13)->value, 14);
+}
+
+/*
+    Вставляемое значение ссылается на элемент самого списка, который сдвигается при вставке
+*/
+
+TEST(UnrolledLinkedList, insertAliasedValue) {
+    std::list<int> std_list;
+    unrolled_list<int, 4> unrolled_list;
+    for (int i = 0; i < 8; ++i) {
+        std_list.push_back(i);
+        unrolled_list.push_back(i);
+    }
+
+    unrolled_list.insert(std::next(unrolled_list.begin(), 1), *std::next(unrolled_list.begin(), 2));
+    std_list.insert(std::next(std_list.begin(), 1), *std::next(std_list.begin(), 2));
+    unrolled_list.insert(std::next(unrolled_list.begin(), 5), 2, *std::next(unrolled_list.begin(), 7));
+    std_list.insert(std::next(std_list.begin(), 5), 2, *std::next(std_list.begin(), 7));
+
+    ASSERT_THAT(unrolled_list, ::testing::ElementsAreArray(std_list));
+}
+
+/*
+    Позиционный доступ: operator[], at, nth, index_of и advance.
+    Индекс строится при первом обращении и должен оставаться корректным
+    после вставок и удалений отдельных элементов
+*/
+
+TEST(UnrolledLinkedList, positionalAccess) {
+    std::vector<int> vector;
+    unrolled_list<int, 6> unrolled_list;
+    for (int i = 0; i < 1000; ++i) {
+        vector.push_back(i);
+        unrolled_list.push_back(i);
+    }
+
+    ASSERT_EQ(unrolled_list[777], 777);
+    ASSERT_EQ(unrolled_list.at(0), 0);
+    ASSERT_THROW(unrolled_list.at(1000), std::out_of_range);
+
+    for (int i = 0; i < 200; ++i) {
+        size_t position = (i * 131) % vector.size();
+        if (i % 4 == 0) {
+            vector.erase(vector.begin() + position);
+            unrolled_list.erase(unrolled_list.nth(position));
+        } else if (i % 4 == 1) {
+            vector.insert(vector.begin() + position, -i);
+            unrolled_list.insert(unrolled_list.nth(position), -i);
+        } else if (i % 4 == 2) {
+            vector.insert(vector.begin(), i);
+            unrolled_list.push_front(i);
+        } else {
+            vector.pop_back();
+            unrolled_list.pop_back();
+        }
+        ASSERT_EQ(unrolled_list[position], vector[position]);
+    }
+
+    for (size_t i = 0; i < vector.size(); i += 17) {
+        ASSERT_EQ(unrolled_list[i], vector[i]);
+        ASSERT_EQ(unrolled_list.index_of(unrolled_list.nth(i)), i);
+    }
+    auto it = unrolled_list.advance(unrolled_list.begin(), 500);
+    ASSERT_EQ(*it, vector[500]);
+    ASSERT_EQ(*unrolled_list.advance(it, -250), vector[250]);
+    ASSERT_TRUE(unrolled_list.nth(vector.size()) == unrolled_list.end());
+}
+
+/*
+    Константные методы индекс не перестраивают: при сброшенном индексе они идут по цепочке нод,
+    чтобы одновременные чтения из разных потоков ничего не писали в список
+
+    Ожидается, что:
+        1. nth, operator[], at и index_of константного списка верны и при сброшенном индексе
+        2. Сброшенный индекс после них так и остаётся сброшенным
+*/
+
+TEST(UnrolledLinkedList, constAccessDoesNotRebuildIndex) {
+    std::vector<int> vector;
+    unrolled_list<int, 6> unrolled_list;
+    for (int i = 0; i < 500; ++i) {
+        vector.push_back(i);
+        unrolled_list.push_back(i);
+    }
+    unrolled_list.insert(unrolled_list.nth(100), -1);
+    vector.insert(vector.begin() + 100, -1);
+    unrolled_list.sort();
+    std::sort(vector.begin(), vector.end());
+    ASSERT_FALSE(unrolled_list.index_valid);
+
+    const auto& const_list = unrolled_list;
+    for (size_t i = 0; i < vector.size(); i += 7) {
+        ASSERT_EQ(const_list[i], vector[i]);
+        ASSERT_EQ(const_list.at(i), vector[i]);
+        ASSERT_EQ(const_list.index_of(const_list.nth(i)), i);
+    }
+    ASSERT_EQ(const_list.index_of(const_list.end()), vector.size());
+    ASSERT_FALSE(unrolled_list.index_valid);
+
+    ASSERT_EQ(unrolled_list[250], vector[250]);
+    ASSERT_TRUE(unrolled_list.index_valid);
+    ASSERT_EQ(const_list[450], vector[450]);
+}
+
+/*
+    После удаления большей части элементов ноды не должны вырождаться:
+    каждая нода, кроме единственной, заполнена не меньше чем на NodeMinSize,
+    а порядок элементов совпадает с std::list
+*/
+
+TEST(UnrolledLinkedList, fillFactorAfterErase) {
+    std::list<int> list;
+    unrolled_list<int, 8> unrolled_list;
+    for (int i = 0; i < 800; ++i) {
+        list.push_back(i);
+        unrolled_list.push_back(i);
+    }
+
+    auto it = unrolled_list.begin();
+    for (int i = 0; it != unrolled_list.end(); ++i) {
+        if (i % 4 != 0) {
+            it = unrolled_list.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    list.remove_if([](int value) { return value % 4 != 0; });
+    unrolled_list.erase(unrolled_list.nth(10), unrolled_list.nth(47));
+    list.erase(std::next(list.begin(), 10), std::next(list.begin(), 47));
+
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+    size_t node_count = 0;
+    for (auto node = unrolled_list.head; node; node = node->next) {
+        ASSERT_GE(node->node_size, 4);
+        ++node_count;
+    }
+    ASSERT_LE(node_count, list.size() / 4);
+
+    ::unrolled_list<int, 8, std::allocator<int>, 0> without_rebalance(800, 1);
+    for (auto it = without_rebalance.begin(); it != without_rebalance.end(); ) {
+        it = std::next(without_rebalance.erase(it));
+    }
+    ASSERT_EQ(without_rebalance.size(), 400);
+    ASSERT_EQ(without_rebalance.head->node_size, 4);
+}
+
+/*
+    compact переупаковывает фрагментированный список в полные ноды,
+    fill_report отражает число нод и их среднюю заполненность
+*/
+
+TEST(UnrolledLinkedList, compactFragmentedList) {
+    ::unrolled_list<int, 8, std::allocator<int>, 0> unrolled_list;
+    std::vector<int> vector;
+    for (int i = 0; i < 800; ++i) {
+        unrolled_list.push_back(i);
+    }
+    ASSERT_EQ(unrolled_list.fill_report().node_count, 100);
+    ASSERT_DOUBLE_EQ(unrolled_list.fill_report().average_fill, 1.0);
+
+    auto it = unrolled_list.begin();
+    for (int i = 0; it != unrolled_list.end(); ++i) {
+        if (i % 8 != 0) {
+            it = unrolled_list.erase(it);
+        } else {
+            vector.push_back(*it);
+            ++it;
+        }
+    }
+    ASSERT_EQ(unrolled_list.fill_report().node_count, 100);
+    ASSERT_DOUBLE_EQ(unrolled_list.fill_report().average_fill, 0.125);
+
+    unrolled_list.compact();
+    auto report = unrolled_list.fill_report();
+    ASSERT_EQ(report.node_count, 13);
+    ASSERT_EQ(report.element_count, 100);
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), vector.begin(), vector.end()));
+    ASSERT_EQ(unrolled_list.tail->node_size, 4);
+    ASSERT_EQ(unrolled_list[99], vector[99]);
+
+    unrolled_list.clear();
+    unrolled_list.shrink_to_fit();
+    ASSERT_EQ(unrolled_list.fill_report().node_count, 0);
+}
+
+/*
+    Вместимость ноды по умолчанию подбирается под бюджет в байтах:
+    нода занимает ровно 4 кэш-линии, заголовок лежит в её начале
+*/
+
+TEST(UnrolledLinkedList, nodeGeometry) {
+    using int_list = ::unrolled_list<int>;
+    static_assert(alignof(int_list::Node) == cache_line_size);
+    static_assert(sizeof(int_list::Node) == 4 * cache_line_size);
+    static_assert(node_capacity_for_budget<int, cache_line_size> == 6);
+    static_assert(sizeof(::unrolled_list<char, node_capacity_for_budget<char, cache_line_size>>::Node) == cache_line_size);
+    static_assert(node_capacity_for_budget<char[1000]> == 1);
+    static_assert(sizeof(::unrolled_list<std::string>::Node) <= 4 * cache_line_size);
+    static_assert(sizeof(::unrolled_list<std::string, node_capacity_for_budget<std::string> + 1>::Node) >
+        4 * cache_line_size);
+
+    int_list unrolled_list;
+    for (int i = 0; i < 100; ++i) {
+        unrolled_list.push_back(i);
+    }
+    ASSERT_EQ(unrolled_list.head->node_size, node_capacity_for_budget<int>);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(unrolled_list.head) % cache_line_size, 0);
+    ASSERT_EQ(static_cast<void*>(unrolled_list.head), static_cast<void*>(&unrolled_list.head->node_size));
+}
+
+/*
+    Вставка диапазонов: пара итераторов, initializer_list, insert_range,
+    append_range и prepend_range, в том числе для однопроходных диапазонов
+*/
+
+TEST(UnrolledLinkedList, rangeInsert) {
+    std::list<int> list = {100, 101, 102, 103, 104, 105};
+    ::unrolled_list<int, 4> unrolled_list(list.begin(), list.end());
+    std::vector<int> batch(11);
+    std::iota(batch.begin(), batch.end(), 0);
+
+    unrolled_list.insert(unrolled_list.nth(2), batch.begin(), batch.end());
+    list.insert(std::next(list.begin(), 2), batch.begin(), batch.end());
+    unrolled_list.insert(unrolled_list.nth(1), {-1, -2});
+    list.insert(std::next(list.begin(), 1), {-1, -2});
+    unrolled_list.insert_range(unrolled_list.end(), std::views::iota(20, 25));
+    list.insert(list.end(), {20, 21, 22, 23, 24});
+
+    std::istringstream input("7 8 9 10 11 12");
+    unrolled_list.append_range(std::ranges::subrange(std::istream_iterator<int>(input), std::istream_iterator<int>()));
+    list.insert(list.end(), {7, 8, 9, 10, 11, 12});
+    unrolled_list.prepend_range(batch | std::views::take(3));
+    list.insert(list.begin(), {0, 1, 2});
+    unrolled_list.insert(unrolled_list.begin(), batch.begin(), batch.begin());
+
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+    ASSERT_EQ(unrolled_list.size(), list.size());
+    for (auto node = unrolled_list.head; node; node = node->next) {
+        ASSERT_EQ(node->next ? node->next->prev : unrolled_list.tail, node);
+    }
+    ASSERT_EQ(unrolled_list[30], *std::next(list.begin(), 30));
+}
+
+/*
+    Вставка диапазона в конец и в начало ноды сначала заполняет свободные слоты соседней ноды
+    и только остаток раскладывает по новым нодам
+
+    Ожидается, что:
+        1. Многократное дописывание коротких диапазонов даёт полностью заполненные ноды
+        2. Так же ведёт себя однопроходный диапазон неизвестной длины
+        3. Вставка в начало ноды дозаполняет предыдущую ноду, итератор указывает на первый новый элемент
+*/
+
+TEST(UnrolledLinkedList, rangeInsertFillsNeighbour) {
+    ::unrolled_list<int, 16> unrolled_list;
+    std::vector<int> expected;
+    for (int i = 0; i < 100; ++i) {
+        unrolled_list.append_range(std::vector<int>{2 * i, 2 * i + 1});
+        expected.push_back(2 * i);
+        expected.push_back(2 * i + 1);
+    }
+    ASSERT_EQ(unrolled_list.node_count, 13);
+    ASSERT_GT(unrolled_list.fill_report().average_fill, 0.95);
+
+    std::istringstream input("1 2 3 4 5");
+    unrolled_list.append_range(std::ranges::subrange(std::istream_iterator<int>(input), std::istream_iterator<int>()));
+    expected.insert(expected.end(), {1, 2, 3, 4, 5});
+    ASSERT_EQ(unrolled_list.node_count, 13);
+
+    unrolled_list.erase(unrolled_list.nth(14), unrolled_list.nth(16));
+    expected.erase(expected.begin() + 14, expected.begin() + 16);
+    ASSERT_EQ(unrolled_list.nth(14).current_index, 0);
+    auto inserted = unrolled_list.insert(unrolled_list.nth(14), {-1, -2, -3});
+    expected.insert(expected.begin() + 14, {-1, -2, -3});
+    ASSERT_EQ(*inserted, -1);
+    ASSERT_EQ(unrolled_list.head->node_size, 16);
+    ASSERT_EQ(unrolled_list.node_count, 14);
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), expected.begin(), expected.end()));
+}
+
+/*
+    resize и assign дописывают копии так же: сначала в свободные слоты хвоста
+
+    Ожидается, что:
+        1. Рост списка маленькими шагами через resize даёт полностью заполненные ноды
+        2. assign в непустой список и конструктор из count копий занимают минимум нод
+*/
+
+TEST(UnrolledLinkedList, resizeFillsTail) {
+    ::unrolled_list<int, 16> unrolled_list;
+    for (size_t size = 3; size <= 300; size += 3) {
+        unrolled_list.resize(size, static_cast<int>(size));
+    }
+    ASSERT_EQ(unrolled_list.size(), 300);
+    ASSERT_EQ(unrolled_list.node_count, 19);
+    for (size_t i = 0; i < 300; ++i) {
+        ASSERT_EQ(unrolled_list[i], static_cast<int>(i / 3 * 3 + 3));
+    }
+
+    unrolled_list.resize(10);
+    unrolled_list.resize(40);
+    ASSERT_EQ(unrolled_list.node_count, 3);
+    ASSERT_EQ(unrolled_list.back(), 0);
+
+    unrolled_list.assign(33, 7);
+    ASSERT_EQ(unrolled_list.node_count, 3);
+    ::unrolled_list<int, 16> filled(48, 1);
+    ASSERT_EQ(filled.node_count, 3);
+    ASSERT_EQ(filled.fill_report().average_fill, 1);
+}
+
+/*
+    splice, split_at и concat перецепляют целые ноды между списками.
+    Результат сравнивается с std::list, размеры и связи нод должны оставаться согласованными
+*/
+
+TEST(UnrolledLinkedList, spliceSplitConcat) {
+    using list_type = ::unrolled_list<int, 4>;
+    auto check = [](const list_type& unrolled_list, const std::list<int>& list) {
+        ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+        ASSERT_EQ(unrolled_list.size(), list.size());
+        size_t nodes = 0;
+        for (auto node = unrolled_list.head; node; node = node->next) {
+            ASSERT_EQ(node->next ? node->next->prev : unrolled_list.tail, node);
+            ++nodes;
+        }
+        ASSERT_EQ(unrolled_list.fill_report().node_count, nodes);
+    };
+    std::list<int> left_list(20);
+    std::iota(left_list.begin(), left_list.end(), 0);
+    std::list<int> right_list(15);
+    std::iota(right_list.begin(), right_list.end(), 100);
+    list_type left(left_list.begin(), left_list.end());
+    list_type right(right_list.begin(), right_list.end());
+
+    left.splice(left.nth(5), right, right.nth(3), right.nth(11));
+    left_list.splice(std::next(left_list.begin(), 5), right_list,
+        std::next(right_list.begin(), 3), std::next(right_list.begin(), 11));
+    check(left, left_list);
+    check(right, right_list);
+
+    list_type tail_part = left.split_at(left.nth(13));
+    std::list<int> tail_list;
+    tail_list.splice(tail_list.begin(), left_list, std::next(left_list.begin(), 13), left_list.end());
+    check(left, left_list);
+    check(tail_part, tail_list);
+
+    right.concat(tail_part);
+    right_list.splice(right_list.end(), tail_list);
+    check(right, right_list);
+    check(tail_part, tail_list);
+
+    left.splice(left.begin(), right);
+    left_list.splice(left_list.begin(), right_list);
+    check(left, left_list);
+    ASSERT_TRUE(right.empty());
+    ASSERT_EQ(left[17], *std::next(left_list.begin(), 17));
+
+    list_type whole = left.split_at(left.begin());
+    ASSERT_TRUE(left.empty());
+    check(whole, left_list);
+}
+
+/*
+    sort и stable_sort сортируют элементы внутри нод и сливают ноды между собой,
+    результат должен совпадать с std::list::sort. Для stable_sort дополнительно проверяется,
+    что равные ключи сохраняют исходный порядок, а merge оставляет свои равные элементы первыми
+*/
+
+TEST(UnrolledLinkedList, sortAndMerge) {
+    std::list<int> list;
+    ::unrolled_list<int, 6> unrolled_list;
+    uint32_t state = 7;
+    for (int i = 0; i < 1000; ++i) {
+        state = state * 1103515245 + 12345;
+        int value = static_cast<int>(state >> 16) % 500;
+        if (i % 3 == 0) {
+            list.push_front(value);
+            unrolled_list.push_front(value);
+        } else {
+            list.push_back(value);
+            unrolled_list.push_back(value);
+        }
+    }
+    unrolled_list.sort();
+    list.sort();
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+    ASSERT_EQ(unrolled_list[700], *std::next(list.begin(), 700));
+
+    unrolled_list.sort(std::greater<>());
+    list.sort(std::greater<>());
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+
+    using Record = std::pair<int, int>;
+    auto by_key = [](const Record& lhs, const Record& rhs) { return lhs.first < rhs.first; };
+    std::list<Record> records;
+    ::unrolled_list<Record, 5> unrolled_records;
+    for (int i = 0; i < 300; ++i) {
+        records.emplace_back((i * 37) % 11, i);
+        unrolled_records.emplace_back((i * 37) % 11, i);
+    }
+    unrolled_records.stable_sort(by_key);
+    records.sort(by_key);
+    ASSERT_TRUE(std::equal(unrolled_records.begin(), unrolled_records.end(), records.begin(), records.end()));
+
+    std::list<Record> other_records;
+    ::unrolled_list<Record, 5> unrolled_other;
+    for (int i = 0; i < 120; ++i) {
+        other_records.emplace_back(i / 11, 1000 + i);
+        unrolled_other.emplace_back(i / 11, 1000 + i);
+    }
+    unrolled_records.merge(unrolled_other, by_key);
+    records.merge(other_records, by_key);
+    ASSERT_TRUE(unrolled_other.empty());
+    ASSERT_TRUE(std::equal(unrolled_records.begin(), unrolled_records.end(), records.begin(), records.end()));
+    ASSERT_EQ(unrolled_records.size(), 420);
+    ASSERT_GE(unrolled_records.fill_report().average_fill, 0.9);
+}
+
+/*
+    remove, remove_if, unique и свободные erase/erase_if удаляют элементы за один проход,
+    уплотняя оставшиеся через границы нод. Результат и количество удалённых элементов
+    должны совпадать с std::list, а опустевшие ноды - освобождаться
+*/
+
+TEST(UnrolledLinkedList, removeIfUnique) {
+    std::list<int> list;
+    ::unrolled_list<int, 8> unrolled_list;
+    for (int i = 0; i < 2000; ++i) {
+        int value = (i * 7919) % 1000;
+        list.push_back(value);
+        unrolled_list.push_back(value);
+    }
+    auto expired = [](int value) { return value % 10 < 3; };
+    size_t removed = list.remove_if(expired);
+    ASSERT_EQ(unrolled_list.remove_if(expired), removed);
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+    ASSERT_LE(unrolled_list.fill_report().node_count, (list.size() + 7) / 8 + 1);
+
+    // Удаляемое значение лежит в самом списке
+    removed = list.remove(list.front());
+    ASSERT_EQ(unrolled_list.remove(unrolled_list.front()), removed);
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+
+    ASSERT_EQ(erase(unrolled_list, 5), std::erase(list, 5));
+
+    // Значение для свободной erase тоже может лежать в самом списке
+    ::unrolled_list<int, 8> aliased = {1, 2, 1, 3, 1, 4};
+    ASSERT_EQ(erase(aliased, aliased.front()), 3);
+    ASSERT_THAT(aliased, ::testing::ElementsAre(2, 3, 4));
+    ::unrolled_list<std::string, 4> strings = {"a", "b", "a", "c", "a", "a", "d"};
+    ASSERT_EQ(erase(strings, strings.front()), 4);
+    ASSERT_THAT(strings, ::testing::ElementsAre("b", "c", "d"));
+    ASSERT_EQ(erase(strings, "c"), 1);
+    ASSERT_THAT(strings, ::testing::ElementsAre("b", "d"));
+    ASSERT_EQ(erase_if(unrolled_list, [](int value) { return value > 900; }),
+        std::erase_if(list, [](int value) { return value > 900; }));
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+
+    unrolled_list.sort();
+    list.sort();
+    removed = list.unique();
+    ASSERT_EQ(unrolled_list.unique(), removed);
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+    ASSERT_EQ(unrolled_list.unique([](int lhs, int rhs) { return rhs - lhs < 5; }),
+        list.unique([](int lhs, int rhs) { return rhs - lhs < 5; }));
+    ASSERT_TRUE(std::equal(unrolled_list.begin(), unrolled_list.end(), list.begin(), list.end()));
+
+    ASSERT_EQ(unrolled_list.remove_if([](int) { return true; }), list.size());
+    ASSERT_TRUE(unrolled_list.empty());
+    ASSERT_EQ(unrolled_list.fill_report().node_count, 0);
+}
+
+/*
+    segments() отдаёт список непрерывными кусками: по одному на ноду и по два на ноду,
+    чей кольцевой буфер перекинулся через конец хранилища. Куски вместе покрывают весь список по порядку,
+    а алгоритмы поверх них совпадают со стандартными
+*/
+
+TEST(UnrolledLinkedList, segmentAlgorithms) {
+    std::vector<int> vector;
+    ::unrolled_list<int, 8> unrolled_list;
+    for (int i = 0; i < 500; ++i) {
+        if (i % 2 == 0) {
+            unrolled_list.push_front(i % 97);
+            vector.insert(vector.begin(), i % 97);
+        } else {
+            unrolled_list.push_back(i % 97);
+            vector.push_back(i % 97);
+        }
+    }
+    static_assert(std::ranges::forward_range<decltype(unrolled_list.segments())>);
+    std::vector<int> flattened;
+    size_t segment_count = 0;
+    for (std::span<int> segment : unrolled_list.segments()) {
+        ASSERT_FALSE(segment.empty());
+        flattened.insert(flattened.end(), segment.begin(), segment.end());
+        ++segment_count;
+    }
+    ASSERT_EQ(flattened, vector);
+    ASSERT_GT(segment_count, unrolled_list.fill_report().node_count);
+
+    ASSERT_EQ(accumulate(unrolled_list, 0L), std::accumulate(vector.begin(), vector.end(), 0L));
+    ASSERT_EQ(count(unrolled_list, 42), std::count(vector.begin(), vector.end(), 42));
+    for (int value : {0, 42, 96, 1000}) {
+        auto found = find(unrolled_list, value);
+        auto expected = std::find(vector.begin(), vector.end(), value);
+        if (expected == vector.end()) {
+            ASSERT_TRUE(found == unrolled_list.end());
+        } else {
+            ASSERT_EQ(unrolled_list.index_of(found), expected - vector.begin());
+        }
+    }
+    std::vector<int> copied(vector.size());
+    ASSERT_EQ(copy(std::as_const(unrolled_list), copied.begin()), copied.end());
+    ASSERT_EQ(copied, vector);
+    for_each(unrolled_list, [](int& value) { value *= 2; });
+    ASSERT_EQ(accumulate(unrolled_list, 0L), 2 * std::accumulate(vector.begin(), vector.end(), 0L));
+}
+
+/*
+    prefetched_segments() отдаёт те же куски, что и segments(), и сам строит индекс позиций.
+    Проверяется список со вставками в середину (индекс сброшен), после удалений (в индексе
+    остаются пустые слоты), с расстоянием предвыборки больше числа нод и пустой список
+*/
+
+TEST(UnrolledLinkedList, prefetchedSegments) {
+    ::unrolled_list<int, 8> unrolled_list;
+    std::vector<int> vector;
+    for (int i = 0; i < 300; ++i) {
+        auto pos = unrolled_list.begin();
+        std::advance(pos, unrolled_list.size() / 2);
+        unrolled_list.insert(pos, i);
+        vector.insert(vector.begin() + vector.size() / 2, i);
+    }
+    auto flatten = [](auto segments) {
+        std::vector<int> result;
+        for (auto segment : segments) {
+            result.insert(result.end(), segment.begin(), segment.end());
+        }
+        return result;
+    };
+    static_assert(std::ranges::forward_range<decltype(unrolled_list.prefetched_segments())>);
+    ASSERT_EQ(flatten(unrolled_list.prefetched_segments()), vector);
+    ASSERT_EQ(flatten(std::as_const(unrolled_list).prefetched_segments<2>()), vector);
+
+    unrolled_list.erase(unrolled_list.nth(10), unrolled_list.nth(100));
+    vector.erase(vector.begin() + 10, vector.begin() + 100);
+    auto joined = unrolled_list.prefetched_segments<1000>() | std::views::join;
+    ASSERT_TRUE(std::ranges::equal(joined, vector));
+    for (int& value : unrolled_list.prefetched_segments() | std::views::join) {
+        value += 1;
+    }
+    ASSERT_EQ(accumulate(unrolled_list, 0L), std::accumulate(vector.begin(), vector.end(), 0L) + vector.size());
+
+    ::unrolled_list<int, 8> empty;
+    ASSERT_TRUE(unrolled_list.prefetched_segments().begin() != unrolled_list.prefetched_segments().end());
+    ASSERT_TRUE(empty.prefetched_segments().begin() == empty.prefetched_segments().end());
+}
+
+/*
+    find, count, contains, min_element, max_element и sum для арифметических типов идут
+    векторными ядрами. Тест проходит все уровни, доступные процессору (скалярный есть всегда),
+    и сверяет результат со стандартными алгоритмами на std::vector
+*/
+
+template<typename T>
+void CheckSimdKernels() {
+    std::vector<T> vector;
+    ::unrolled_list<T, 29> unrolled_list;
+    for (int i = 0; i < 700; ++i) {
+        T value = static_cast<T>((i * 37) % 101);
+        if (i % 3 == 0) {
+            unrolled_list.push_front(value);
+            vector.insert(vector.begin(), value);
+        } else {
+            unrolled_list.push_back(value);
+            vector.push_back(value);
+        }
+    }
+    for (T needle : {T(0), T(50), T(100), T(120)}) {
+        auto found = find(unrolled_list, needle);
+        auto expected = std::find(vector.begin(), vector.end(), needle);
+        ASSERT_EQ(contains(unrolled_list, needle), expected != vector.end());
+        if (expected == vector.end()) {
+            ASSERT_TRUE(found == unrolled_list.end());
+        } else {
+            ASSERT_EQ(unrolled_list.index_of(found), expected - vector.begin());
+        }
+        ASSERT_EQ(count(unrolled_list, needle), std::count(vector.begin(), vector.end(), needle));
+    }
+    ASSERT_EQ(unrolled_list.index_of(min_element(unrolled_list)),
+        std::min_element(vector.begin(), vector.end()) - vector.begin());
+    ASSERT_EQ(unrolled_list.index_of(max_element(unrolled_list)),
+        std::max_element(vector.begin(), vector.end()) - vector.begin());
+    ASSERT_EQ(sum(unrolled_list), std::accumulate(vector.begin(), vector.end(), decltype(sum(unrolled_list))()));
+}
+
+TEST(UnrolledLinkedList, simdKernels) {
+    simd_level detected = active_simd_level();
+    for (simd_level level : {simd_level::scalar, simd_level::sse2, simd_level::avx2}) {
+        if (set_simd_level(level) != level) {
+            continue;
+        }
+        CheckSimdKernels<int>();
+        CheckSimdKernels<unsigned char>();
+        CheckSimdKernels<char>();
+        CheckSimdKernels<short>();
+        CheckSimdKernels<long long>();
+        CheckSimdKernels<float>();
+        CheckSimdKernels<double>();
+    }
+    set_simd_level(detected);
+
+    // NaN не упорядочен, поэтому min_element и max_element уходят в скалярный путь
+    std::vector<double> vector = {3, 1, std::numeric_limits<double>::quiet_NaN(), 0, 5, 0};
+    ::unrolled_list<double, 4> unrolled_list(vector.begin(), vector.end());
+    ASSERT_EQ(unrolled_list.index_of(min_element(unrolled_list)),
+        std::min_element(vector.begin(), vector.end()) - vector.begin());
+    ASSERT_EQ(unrolled_list.index_of(max_element(unrolled_list)),
+        std::max_element(vector.begin(), vector.end()) - vector.begin());
+}
@@ -0,0 +1,158 @@
+#include <slab_allocator.h>
+#include <unrolled_list.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+template<class Alloc>
+concept AllocatorRequirements = requires(Alloc alloc, std::size_t n)
+{
+    { *alloc.allocate(n) } -> std::same_as<typename Alloc::value_type&>;
+    { alloc.deallocate(alloc.allocate(n), n) };
+} && std::copy_constructible<Alloc>
+  && std::equality_comparable<Alloc>;
+
+static_assert(AllocatorRequirements<slab_allocator<int>>);
+
+/*
+    Список с slab_allocator получает ноды из арены через rebind_alloc<Node>.
+
+    Ожидается, что:
+        1. Все ноды выровнены по кэш-линии
+        2. Список ведёт себя как обычный
+        3. Ноды берутся из одного слэба, а не выделяются по одной
+*/
+
+TEST(SlabAllocatorTest, nodesComeFromArena) {
+    slab_arena arena;
+    using unrolled_list_type = unrolled_list<std::string, 8, slab_allocator<std::string>>;
+    unrolled_list_type list{slab_allocator<std::string>(arena)};
+    for (int i = 0; i < 100; ++i) {
+        list.push_back(std::to_string(i));
+    }
+
+    for (auto node = list.head; node; node = node->next) {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(node) % slab_arena::cache_line_size, 0);
+    }
+    ASSERT_EQ(list.size(), 100);
+    ASSERT_EQ(list.front(), "0");
+    ASSERT_EQ(list.back(), "99");
+    ASSERT_EQ(arena.slab_count, 1);
+}
+
+/*
+    Освобождённые ноды возвращаются в арену и переиспользуются.
+
+    Ожидается, что:
+        1. Многократное заполнение и очистка списка не выделяют новых слэбов
+        2. Копия списка с тем же аллокатором живёт в той же арене
+*/
+
+TEST(SlabAllocatorTest, freedNodesAreReused) {
+    slab_arena arena(4096);
+    using unrolled_list_type = unrolled_list<int, 16, slab_allocator<int>>;
+    unrolled_list_type list{slab_allocator<int>(arena)};
+    for (int i = 0; i < 200; ++i) {
+        list.push_back(i);
+    }
+    size_t slabs = arena.slab_count;
+
+    for (int round = 0; round < 50; ++round) {
+        list.clear();
+        list.trim();
+        for (int i = 0; i < 200; ++i) {
+            list.push_back(i);
+        }
+    }
+    ASSERT_EQ(arena.slab_count, slabs);
+
+    unrolled_list_type copy(list);
+    ASSERT_TRUE(copy.node_allocator == list.node_allocator);
+    ASSERT_TRUE(copy == list);
+}
+
+/*
+    Блок больше слэба получает собственный слэб, а release возвращает всю память разом.
+
+    Ожидается, что:
+        1. Крупный блок выровнен по кэш-линии и не сбивает нарезку текущего слэба
+        2. После release в арене нет слэбов, и она снова пригодна для работы
+*/
+
+TEST(SlabAllocatorTest, largeBlocksAndRelease) {
+    slab_arena arena(1024);
+    slab_allocator<char> allocator(arena);
+
+    char* small = allocator.allocate(10);
+    char* large = allocator.allocate(10000);
+    char* next_small = allocator.allocate(10);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(large) % slab_arena::cache_line_size, 0);
+    ASSERT_EQ(next_small - small, static_cast<std::ptrdiff_t>(slab_arena::cache_line_size));
+    ASSERT_EQ(arena.slab_count, 2);
+
+    allocator.deallocate(small, 10);
+    ASSERT_EQ(allocator.allocate(20), small);
+
+    arena.release();
+    ASSERT_EQ(arena.slab_count, 0);
+    ASSERT_NE(allocator.allocate(10), nullptr);
+    ASSERT_EQ(arena.slab_count, 1);
+}
+
+/*
+    slab_allocator распространяется при присваивании и обмене, поэтому список может сменить арену.
+    Массивы индекса позиций выделяются тем же аллокатором, что и ноды.
+
+    Ожидается, что:
+        1. После перемещения, копирования и обмена индекс не ссылается на память старой арены:
+           позиционный доступ работает и после уничтожения арены, в которой список жил раньше
+        2. При обмене индекс уходит вместе с аллокатором и остаётся рабочим у второго списка
+*/
+
+TEST(SlabAllocatorTest, indexFollowsAllocator) {
+    using unrolled_list_type = unrolled_list<int, 4, slab_allocator<int>>;
+    auto fill = [](unrolled_list_type& list, int first) {
+        for (int i = 0; i < 100; ++i) {
+            list.push_back(first + i);
+        }
+        ASSERT_EQ(list[50], first + 50);
+    };
+    auto first_arena = std::make_unique<slab_arena>(4096);
+    slab_arena second_arena(4096);
+    unrolled_list_type moved_to{slab_allocator<int>(*first_arena)};
+    unrolled_list_type copied_to{slab_allocator<int>(*first_arena)};
+    unrolled_list_type swapped{slab_allocator<int>(*first_arena)};
+    fill(moved_to, 0);
+    fill(copied_to, 0);
+    fill(swapped, 0);
+    {
+        unrolled_list_type source{slab_allocator<int>(second_arena)};
+        fill(source, 1000);
+        moved_to = std::move(source);
+
+        unrolled_list_type copy_source{slab_allocator<int>(second_arena)};
+        fill(copy_source, 2000);
+        copied_to = copy_source;
+
+        unrolled_list_type swap_source{slab_allocator<int>(second_arena)};
+        fill(swap_source, 3000);
+        swapped.swap(swap_source);
+        ASSERT_EQ(swap_source[5], 5);
+        swap_source.push_back(100);
+        ASSERT_EQ(swap_source[100], 100);
+    }
+    first_arena.reset();
+
+    ASSERT_EQ(moved_to[5], 1005);
+    ASSERT_EQ(copied_to[5], 2005);
+    ASSERT_EQ(swapped[5], 3005);
+    for (unrolled_list_type* list : {&moved_to, &copied_to, &swapped}) {
+        list->insert(list->nth(10), -1);
+        ASSERT_EQ((*list)[10], -1);
+        ASSERT_EQ(list->index_of(list->nth(99)), 99);
+    }
+}
@@ -0,0 +1,188 @@
+#include <tiered_unrolled_list.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// Проверяет, что размеры поддеревьев, родительские указатели и цепочка листьев согласованы
+template<typename List>
+size_t CheckSubtree(const List& list, const typename List::Branch* branch) {
+    size_t total = 0;
+    for (size_t i = 0; i < branch->child_count; ++i) {
+        EXPECT_EQ(branch->children[i]->parent, branch);
+        size_t count = branch->leaf_children
+            ? static_cast<const typename List::Node*>(branch->children[i])->node_size
+            : CheckSubtree(list, static_cast<const typename List::Branch*>(branch->children[i]));
+        EXPECT_EQ(branch->counts[i], count);
+        total += count;
+    }
+    return total;
+}
+
+template<typename List>
+void CheckTree(const List& list) {
+    if (list.root == nullptr) {
+        EXPECT_EQ(list.size(), 0);
+        EXPECT_EQ(list.head, nullptr);
+        return;
+    }
+    EXPECT_EQ(CheckSubtree(list, list.root), list.size());
+    size_t total = 0;
+    for (auto node = list.head; node; node = node->next) {
+        EXPECT_GT(node->node_size, 0);
+        total += node->node_size;
+    }
+    EXPECT_EQ(total, list.size());
+}
+
+/*
+    Случайные позиционные вставки и удаления сравниваются с std::vector.
+    Маленькие NodeMaxSize и Fanout дают глубокое дерево, поэтому задействуются
+    разбиения, заимствования и слияния на всех уровнях
+*/
+TEST(TieredUnrolledList, randomPositionalOperations) {
+    tiered_unrolled_list<int, 3, std::allocator<int>, 4> list;
+    std::vector<int> expected;
+    std::mt19937 rng(17);
+
+    for (int step = 0; step < 20000; ++step) {
+        size_t position = expected.empty() ? 0 : rng() % (expected.size() + 1);
+        if (rng() % 5 < 3 || expected.empty()) {
+            list.insert(list.nth(position), step);
+            expected.insert(expected.begin() + position, step);
+        } else {
+            position = position % expected.size();
+            list.erase(list.nth(position));
+            expected.erase(expected.begin() + position);
+        }
+        if (step % 1000 == 0) {
+            CheckTree(list);
+        }
+    }
+
+    CheckTree(list);
+    ASSERT_EQ(list.size(), expected.size());
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    for (size_t i = 0; i < expected.size(); i += 7) {
+        ASSERT_EQ(list[i], expected[i]);
+        ASSERT_EQ(list.index_of(list.nth(i)), i);
+    }
+
+    while (!expected.empty()) {
+        size_t position = rng() % expected.size();
+        list.erase(list.nth(position));
+        expected.erase(expected.begin() + position);
+    }
+    CheckTree(list);
+    ASSERT_TRUE(list.empty());
+}
+
+/*
+    Последовательные push_back и push_front заводят новый лист за полным крайним,
+    а не делят его, поэтому листья остаются заполненными, как ноды unrolled_list
+*/
+TEST(TieredUnrolledList, sequentialFillKeepsLeavesFull) {
+    tiered_unrolled_list<int, 10> back;
+    tiered_unrolled_list<int, 10> front;
+    for (int i = 0; i < 1000; ++i) {
+        back.push_back(i);
+        front.push_front(i);
+    }
+    size_t back_leaves = 0;
+    for (auto node = back.head; node; node = node->next) {
+        EXPECT_EQ(node->node_size, 10);
+        ++back_leaves;
+    }
+    size_t front_leaves = 0;
+    for (auto node = front.head; node; node = node->next) {
+        EXPECT_EQ(node->node_size, 10);
+        ++front_leaves;
+    }
+    ASSERT_EQ(back_leaves, 100);
+    ASSERT_EQ(front_leaves, 100);
+    ASSERT_EQ(back[537], 537);
+    ASSERT_EQ(front[537], 462);
+    CheckTree(back);
+    CheckTree(front);
+}
+
+/*
+    Вставки повторов и удаления диапазонов в случайные позиции сравниваются с std::vector.
+
+    Ожидается, что:
+        1. Содержимое совпадает с std::vector, вставка возвращает итератор на первую копию
+        2. Копии строятся целыми листьями: листьев после большой вставки почти столько же,
+           сколько нужно при полном заполнении
+        3. Размеры поддеревьев остаются согласованными
+*/
+TEST(TieredUnrolledList, rangeOperations) {
+    tiered_unrolled_list<int, 5, std::allocator<int>, 4> list;
+    std::vector<int> expected;
+    std::mt19937 rng(8);
+
+    for (int step = 0; step < 3000; ++step) {
+        size_t position = rng() % (expected.size() + 1);
+        size_t count = rng() % 23;
+        if (rng() % 2 == 0 || expected.size() < 50) {
+            auto inserted = list.insert(list.nth(position), count, step);
+            expected.insert(expected.begin() + position, count, step);
+            ASSERT_EQ(list.index_of(inserted), position);
+        } else {
+            count = std::min(count * 3, expected.size() - position);
+            list.erase(list.nth(position), list.nth(position + count));
+            expected.erase(expected.begin() + position, expected.begin() + position + count);
+        }
+        if (step % 100 == 0) {
+            CheckTree(list);
+        }
+    }
+    CheckTree(list);
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+
+    tiered_unrolled_list<int, 10> wide(100, 0);
+    wide.insert(wide.nth(55), 1000, 1);
+    size_t leaves = 0;
+    for (auto node = wide.head; node; node = node->next) {
+        ++leaves;
+    }
+    ASSERT_LE(leaves, wide.size() / 10 + 2);
+    ASSERT_EQ(wide[54], 0);
+    ASSERT_EQ(wide[55], 1);
+    ASSERT_EQ(wide[1054], 1);
+    ASSERT_EQ(wide[1055], 0);
+    wide.erase(wide.nth(3), wide.nth(1095));
+    ASSERT_EQ(wide.size(), 8);
+    ASSERT_EQ(std::count(wide.begin(), wide.end(), 0), 8);
+    CheckTree(wide);
+}
+
+TEST(TieredUnrolledList, stlInterface) {
+    tiered_unrolled_list<std::string, 4, std::allocator<std::string>, 4> list = {"b", "c"};
+    list.push_front("a");
+    list.emplace_back(3, 'd');
+    list.insert(list.nth(1), 2, list.front());
+    list.erase(list.nth(3), list.end());
+
+    std::vector<std::string> expected = {"a", "a", "a"};
+    ASSERT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    ASSERT_EQ(*std::prev(list.end()), "a");
+    ASSERT_THROW(list.at(3), std::out_of_range);
+
+    auto copy = list;
+    ASSERT_EQ(copy, list);
+    auto moved = std::move(copy);
+    ASSERT_TRUE(copy.empty());
+    ASSERT_EQ(moved, list);
+
+    for (int i = 0; i < 100; ++i) {
+        moved.push_back(std::to_string(i));
+    }
+    moved.erase(moved.begin(), moved.nth(3));
+    ASSERT_EQ(moved.front(), "0");
+    ASSERT_EQ(moved.back(), "99");
+    ASSERT_EQ(*moved.rbegin(), "99");
+    CheckTree(moved);
+}